@@ -3,6 +3,8 @@
 #include "resource_dir.h"
 
 #include "Agent.h"
+#include "Random.h"
+#include "TargetPrediction.h"
 
 // This boilerplate purely exists so we can override it
 Vector2 SeekBehavior::getTargetDirection(Agent& agent, Object* player) {
@@ -36,44 +38,18 @@ Vector2 FleeBehavior::getTargetDirection(Agent& agent, Object* player) {
 }
 
 // Pursue inherits from seek but ovewrrites targetDirection with a prediction
+// The prediction itself is shared with evade, see TargetPrediction.h
 Vector2 PursueBehavior::getTargetDirection(Agent& agent, Object* player) {
 	// Hard Setting rotation smoothness isn't ideal,
 	// but I had to make it react faster when making predictions
 	agent.rotationSmoothness = 0.2f;
-	float maxPrediction = 50.0f;
-	Vector2 toTarget = player->position - agent.position;
-	float distance = Vector2Length(toTarget);
-
-	float prediction;
-	if (distance <= maxPrediction)
-		return toTarget;
-	else if (agent.speed <= distance / maxPrediction)
-		prediction = maxPrediction;
-	else
-		prediction = distance / agent.speed;
-
-	toTarget += player->GetVelocity() * prediction;
-	return toTarget;
+	return predictTargetDirection(agent.position, agent.speed, targetPredictions().get(player), 1.0f);
 }
 
-// Bit ugly copy paste below, but I didn't realize pursue would need to inherit from seek and then evade inherit from puruse
-// As I only planned this whole architechture to be one layer of inheritence at most for some stupid reason
+// Same kernel as pursue, just pointing the other way
 Vector2 EvadeBehavior::getTargetDirection(Agent& agent, Object* player) {
 	agent.rotationSmoothness = 0.2f;
-	float maxPrediction = 50.0f;
-	Vector2 toTarget = agent.position - player->position;
-	float distance = Vector2Length(toTarget);
-
-	float prediction;
-	if (distance <= maxPrediction)
-		return toTarget;
-	else if (agent.speed <= distance / maxPrediction)
-		prediction = maxPrediction;
-	else
-		prediction = distance / agent.speed;
-
-	toTarget += player->GetVelocity() * prediction;
-	return toTarget;
+	return predictTargetDirection(agent.position, agent.speed, targetPredictions().get(player), -1.0f);
 }
 
 // Note: ArriveBehavior boilerplate
@@ -119,10 +95,10 @@ void ArriveBehavior::execute(Agent& agent, Object* player) {
 // Since seek does: float desiredRotation = agent.steering.newOrientation(agent.orientation, toTarget)
 void WanderBehavior::execute(Agent& agent, Object* player) {
 	agent.rotationSmoothness = 0.2f;
-	int binomial = GetRandomValue(-1, 1);
+	int binomial = randomRange(randomKey(agent.id), agent.behaviorState.randomDraws++, -1, 1);
 
-	wanderOrientation += binomial * wanderRate;
-	float targetOrientation = wanderOrientation + agent.orientation;
+	agent.behaviorState.wanderOrientation += binomial * wanderRate;
+	float targetOrientation = agent.behaviorState.wanderOrientation + agent.orientation;
 
 	Vector2 target = agent.position + Vector2{ cosf(agent.orientation), sinf(agent.orientation) } * wanderOffset;
 	target += Vector2{ cosf(targetOrientation), sinf(targetOrientation) } * wanderRadius;
@@ -151,6 +127,14 @@ void WanderBehavior::execute(Agent& agent, Object* player) {
 	agent.position += agent.velocity;
 }
 
+// The perception pass hands over the centroid of whatever is in the view cone, or nothing if the cone is empty
+void ObstacleAndPlayerAvoidanceBehavior::execute(Agent& agent, Object* ObjectToAvoid) {
+	if (ObjectToAvoid)
+		getBehaviorInstance(Flee)->execute(agent, ObjectToAvoid);
+	else
+		WanderBehavior::execute(agent, ObjectToAvoid);
+}
+
 // Generic Agent related:
 float SteeringOutput::newOrientation(float currentAgentOrientation, Vector2 targetObject) {
 	const float eps = 0.001f;
@@ -174,8 +158,10 @@ Agent::Agent(Vector2 pos, int initialRadius, float initialSpeed, float initialOr
 	rotation = { 0, 0 };
 	_currentBehavior = Seek;
 	previousBehavior = Flee;
-	playerTarget = nullptr;
+	playerTarget = EntityHandle::invalid();
 	behaviorImpl = nullptr;
+	static uint32_t nextId = 0;
+	id = nextId++;
 }
 
 void Agent::OutOfBoundsChecker() {
@@ -190,16 +176,42 @@ void Agent::OutOfBoundsChecker() {
 }
 
 void Agent::updateFrame(Object* plyr) {
-	updateBehavior();
+	Object** target = objectTable().get(playerTarget);
+	updateFrame(plyr, target ? *target : nullptr);
+}
+
+// Used by the scenarios that resolve every agent's target in one go (HandleTable::resolveAll)
+void Agent::updateFrame(Object* plyr, Object* resolvedTarget) {
+	updateBehavior(resolvedTarget);
 	setBehavior();
 	drawAgent();
 	OutOfBoundsChecker();
-	playerTarget = plyr;
+	playerTarget = plyr ? plyr->handle : EntityHandle::invalid();
+}
+
+void Agent::updateBehavior(Object* resolvedTarget) {
+	if (behaviorImpl && resolvedTarget)
+		behaviorImpl->execute(*this, resolvedTarget);
 }
 
-void Agent::updateBehavior() {
-	if (behaviorImpl && playerTarget)
-		behaviorImpl->execute(*this, playerTarget);
+MovementBehavior* getBehaviorInstance(Behaviors behavior) {
+	// None of these hold any state so every agent can share them
+	static SeekBehavior seek;
+	static FleeBehavior flee;
+	static PursueBehavior pursue;
+	static EvadeBehavior evade;
+	static ArriveBehavior arrive;
+	static WanderBehavior wander;
+
+	switch (behavior) {
+	case Seek: return &seek;
+	case Flee: return &flee;
+	case Pursue: return &pursue;
+	case Evade: return &evade;
+	case Arrive: return &arrive;
+	case Wander: return &wander;
+	default: return nullptr;
+	}
 }
 
 // I've hard coded the behaviors down here, 
@@ -218,29 +230,12 @@ void Agent::setBehavior() {
 	if (_currentBehavior == previousBehavior)
 		return;
 	previousBehavior = _currentBehavior;
-	switch (_currentBehavior) {
-	case Seek:
-		behaviorImpl = std::make_unique<SeekBehavior>();
-		break;
-	case Flee:
-		behaviorImpl = std::make_unique<FleeBehavior>();
-		break;
-	case Pursue:
-		behaviorImpl = std::make_unique<PursueBehavior>();
-		break;
-	case Evade:
-		behaviorImpl = std::make_unique<EvadeBehavior>();
-		break;
-	case Arrive:
-		behaviorImpl = std::make_unique<ArriveBehavior>();
-		break;
-	case Wander:
-		behaviorImpl = std::make_unique<WanderBehavior>();
-		break;
-	default:
+
+	// Shared flyweight, so no allocation here, only the per agent state gets reset
+	behaviorImpl = getBehaviorInstance(_currentBehavior);
+	behaviorState = AgentBehaviorState();
+	if (!behaviorImpl)
 		DrawText("Error, most likely invalid option picked", 10, GetScreenHeight(), 20, RED);
-		break;
-	}
 }
 
 void Agent::drawAgent() {
@@ -262,9 +257,13 @@ void Agent::displayDebug() {
 		break;
 	case Pursue:
 		DrawText("3/6 Type: Pursue", 10, GetScreenHeight() - 50, 20, RED);
+		DrawText(predictionMode() == InterceptPrediction ? "Prediction (I to toggle): exact intercept" : "Prediction (I to toggle): distance / speed",
+			10, GetScreenHeight() - 75, 20, RED);
 		break;
 	case Evade:
 		DrawText("4/6 Type: Evade", 10, GetScreenHeight() - 50, 20, RED);
+		DrawText(predictionMode() == InterceptPrediction ? "Prediction (I to toggle): exact intercept" : "Prediction (I to toggle): distance / speed",
+			10, GetScreenHeight() - 75, 20, RED);
 		break;
 	case Arrive:
 		DrawText("5/6 Type: Arrive", 10, GetScreenHeight() - 50, 20, RED);
@@ -284,4 +283,7 @@ void Agent::displayDebug() {
 	if (IsKeyPressed(KEY_FOUR)) _currentBehavior = Evade;
 	if (IsKeyPressed(KEY_FIVE)) _currentBehavior = Arrive;
 	if (IsKeyPressed(KEY_SIX)) _currentBehavior = Wander;
+
+	if (IsKeyPressed(KEY_I))
+		predictionMode() = predictionMode() == InterceptPrediction ? HeuristicPrediction : InterceptPrediction;
 }
\ No newline at end of file
@@ -1,7 +1,5 @@
 #pragma once
 
-#include <memory>
-
 #include "raylib.h"
 #include "raymath.h"
 #include "resource_dir.h"
@@ -22,6 +20,8 @@ struct Object;
 
 // Abstract base class for movement
 // Followed by behavior declarations (C++ thing)
+// Behaviors are stateless flyweights: one shared instance per behavior type (see getBehaviorInstance)
+// Anything an agent needs to remember between frames goes into AgentBehaviorState instead
 struct MovementBehavior {
 	virtual ~MovementBehavior() = default;
 	virtual void execute(Agent& agent, Object* player) = 0;
@@ -55,10 +55,9 @@ struct EvadeBehavior : PursueBehavior {
 };
 
 struct WanderBehavior : MovementBehavior {
-	float wanderOrientation = 1.0f;
-	float wanderOffset = 250;
-	float wanderRadius = 35;
-	float wanderRate = 1.0f;
+	const float wanderOffset = 250;
+	const float wanderRadius = 35;
+	const float wanderRate = 1.0f;
 	void execute(Agent& agent, Object* player) override;
 };
 
@@ -73,6 +72,16 @@ struct SteeringOutput {
 	float newOrientation(float currentAgentOrientation, Vector2 targetObject);
 };
 
+// Per agent mutable state used by the shared behaviors, reset whenever the behavior changes
+struct AgentBehaviorState {
+	float wanderOrientation = 1.0f;
+	// How many random numbers this agent has drawn, it's the counter for its stream (Random.h)
+	uint32_t randomDraws = 0;
+};
+
+// Returns the shared instance for a behavior, so switching is just a pointer store
+MovementBehavior* getBehaviorInstance(Behaviors behavior);
+
 // Generic agent-related functionality defined here
 struct Agent
 {
@@ -87,8 +96,12 @@ struct Agent
 	float speed;
 	Behaviors _currentBehavior;
 	Behaviors previousBehavior;
-	std::unique_ptr<MovementBehavior> behaviorImpl;
-	Object* playerTarget;
+	MovementBehavior* behaviorImpl;
+	AgentBehaviorState behaviorState;
+	// Handle rather than pointer so a despawned target is detected, resolved through objectTable()
+	EntityHandle playerTarget;
+	// Unique per agent, used as its random stream
+	uint32_t id;
 	SteeringOutput steering;
 	bool drawDebugLines;
 	Agent(Vector2 pos, int initialRadius, float initialSpeed, 
@@ -96,7 +109,8 @@ struct Agent
 
 	void OutOfBoundsChecker();
 	void updateFrame(Object* plyr);
-	void updateBehavior();
+	void updateFrame(Object* plyr, Object* resolvedTarget);
+	void updateBehavior(Object* resolvedTarget);
 	void setBehavior();
 	void drawAgent();
 	void displayDebug();
@@ -0,0 +1,74 @@
+#include <algorithm>
+
+#include "AgentScript.h"
+
+void* AgentScript::promise_type::markFrame(void* memory, bool onHeap) {
+	*static_cast<bool*>(memory) = onHeap;
+	return static_cast<char*>(memory) + frameHeader;
+}
+
+void AgentScript::promise_type::operator delete(void* frame) {
+	void* memory = static_cast<char*>(frame) - frameHeader;
+	if (*static_cast<bool*>(memory))
+		::operator delete(memory);
+}
+
+AgentScript& AgentScript::operator=(AgentScript&& other) noexcept {
+	if (this != &other) {
+		stop();
+		handle = other.handle;
+		other.handle = nullptr;
+	}
+	return *this;
+}
+
+void AgentScript::start() {
+	if (handle && !handle.done())
+		handle.resume();
+}
+
+void AgentScript::stop() {
+	if (!handle)
+		return;
+	promise_type& promise = handle.promise();
+	if (promise.event) {
+		std::vector<std::coroutine_handle<>>& waiters = promise.event->waiters;
+		waiters.erase(std::remove(waiters.begin(), waiters.end(), std::coroutine_handle<>(handle)), waiters.end());
+	}
+	if (promise.wheel)
+		promise.wheel->cancel(promise.timer);
+	handle.destroy();
+	handle = nullptr;
+}
+
+void ScriptEvent::reserve(int count) {
+	waiters.reserve(count);
+	resuming.reserve(count);
+}
+
+void ScriptEvent::Awaiter::await_suspend(std::coroutine_handle<AgentScript::promise_type> handle) {
+	handle.promise().event = &event;
+	handle.promise().wheel = nullptr;
+	event.waiters.push_back(handle);
+}
+
+void ScriptEvent::fire() {
+	if (waiters.empty())
+		return;
+	// Swapped out first, anyone awaiting this again while being resumed goes into the fresh list
+	resuming.swap(waiters);
+	for (std::coroutine_handle<> handle : resuming)
+		handle.resume();
+	resuming.clear();
+	fired++;
+}
+
+static void resumeScript(void* address, uint64_t) {
+	std::coroutine_handle<>::from_address(address).resume();
+}
+
+void ScriptScheduler::WaitAwaiter::await_suspend(std::coroutine_handle<AgentScript::promise_type> handle) {
+	handle.promise().event = nullptr;
+	handle.promise().wheel = &scheduler.timers;
+	handle.promise().timer = scheduler.timers.schedule(ticks, resumeScript, handle.address());
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+#include "TimingWheel.h"
+
+// Agent scripts as C++20 coroutines.
+// Multi step logic ("Go to the node, then the next one, then make a new path") reads top to bottom in one function
+// Instead of being a state machine spread over member fields that's checked every frame.
+// A script co_awaits a ScriptEvent (Arrived, landed) or a timer from its ScriptScheduler, and while it's suspended
+// It isn't touched at all: events resume their waiters only when they're fired, and timers sit in a timing wheel
+// (TimingWheel.h) so a frame only looks at the ones that are due.
+//
+// Whatever detects the event (The movement code noticing the agent is at its node) still runs every frame,
+// But that's work the frame did anyway, the script itself only runs when something happened.
+//
+// A script that's a member function of something with an arena (Like the scenarios in ComposedAgents.h)
+// Gets its coroutine frame from that arena, so starting one doesn't touch the heap either.
+
+struct ScriptEvent;
+
+struct AgentScript {
+	struct promise_type {
+		// What it's suspended on, so stop() can take it back out
+		ScriptEvent* event = nullptr;
+		TimingWheel* wheel = nullptr;
+		TimerHandle timer = TimerHandle::invalid();
+
+		AgentScript get_return_object() { return AgentScript(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		// Nothing runs until start(), so a script can be made in a constructor before everything it uses is set up
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		// Stays around after finishing so AgentScript can still check done() and destroy it
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		// There are no exceptions anywhere else in here either
+		void unhandled_exception() { std::terminate(); }
+
+		// Member function scripts of anything with an arena member, the object is the first argument
+		template<typename Owner, typename... Args>
+			requires requires(Owner& owner) { owner.arena.allocate(size_t(), size_t()); }
+		static void* operator new(size_t size, Owner& owner, Args&...) {
+			return markFrame(owner.arena.allocate(size + frameHeader, alignof(std::max_align_t)), false);
+		}
+		static void* operator new(size_t size) { return markFrame(::operator new(size + frameHeader), true); }
+		// Arena frames are given back when the arena resets, so only heap frames are deleted here.
+		// Which one it was is kept in a small header in front of the frame
+		static void operator delete(void* frame);
+
+		static constexpr size_t frameHeader = alignof(std::max_align_t);
+		static void* markFrame(void* memory, bool onHeap);
+	};
+
+	std::coroutine_handle<promise_type> handle;
+
+	AgentScript() : handle(nullptr) {}
+	explicit AgentScript(std::coroutine_handle<promise_type> _handle) : handle(_handle) {}
+	AgentScript(AgentScript&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+	AgentScript& operator=(AgentScript&& other) noexcept;
+	AgentScript(const AgentScript&) = delete;
+	AgentScript& operator=(const AgentScript&) = delete;
+	~AgentScript() { stop(); }
+
+	// Runs the script up to its first co_await
+	void start();
+	// Destroys the coroutine wherever it's suspended, and takes it off the event or timer it was waiting for.
+	// So stop scripts before the events and scheduler they wait on go away
+	void stop();
+	bool done() const { return !handle || handle.done(); }
+};
+
+// Something scripts wait for, fire() resumes everyone waiting on it right now.
+// A script that awaits the same event again while being resumed waits for the next fire()
+struct ScriptEvent {
+	std::vector<std::coroutine_handle<>> waiters;
+	std::vector<std::coroutine_handle<>> resuming;
+	// How many times fire() actually woke someone, for the overlay
+	int fired = 0;
+
+	ScriptEvent() { reserve(4); }
+	void reserve(int count);
+	void fire();
+
+	struct Awaiter {
+		ScriptEvent& event;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<AgentScript::promise_type> handle);
+		void await_resume() const noexcept {}
+	};
+	Awaiter operator co_await() { return Awaiter{ *this }; }
+};
+
+// Owns the clock the timers run on, update() once per frame
+struct ScriptScheduler {
+	TimingWheel timers;
+
+	ScriptScheduler() { timers.reserve(8); }
+	void update() { timers.advance(); }
+	// Scripts resumed by timers last update, for the overlay
+	int resumed() const { return timers.fired; }
+
+	struct WaitAwaiter {
+		ScriptScheduler& scheduler;
+		uint32_t ticks;
+		bool await_ready() const noexcept { return ticks == 0; }
+		void await_suspend(std::coroutine_handle<AgentScript::promise_type> handle);
+		void await_resume() const noexcept {}
+	};
+	// co_await scheduler.wait(30) resumes the script 30 updates from now
+	WaitAwaiter wait(uint32_t ticks) { return WaitAwaiter{ *this, ticks }; }
+};
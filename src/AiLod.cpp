@@ -0,0 +1,64 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "AiLod.h"
+
+// Beyond each of these distances an agent drops a level
+static const float lodDistances[AiLodLevelCount - 1] = { 300.0f, 600.0f, 1000.0f };
+static const float idleSpeed = 0.05f;
+
+static std::vector<Vector2> playerPositions;
+
+// From the last tick, for the overlay
+static int levelCounts[AiLodLevelCount];
+static int idleCount = 0;
+static int dueCount = 0;
+
+void aiLodSystem(World& world) {
+	playerPositions.clear();
+	world.forEachArchetype(PositionBit | PlayerInputBit, [](Archetype& a) {
+		for (int i = 0; i < a.size(); i++)
+			playerPositions.push_back(a.positions[i].value);
+	});
+
+	for (int level = 0; level < AiLodLevelCount; level++)
+		levelCounts[level] = 0;
+	idleCount = 0;
+	dueCount = 0;
+
+	uint32_t tick = world.tick;
+	world.forEachArchetype(PositionBit | VelocityBit | AiLodBit, [tick](Archetype& a) {
+		bool steered = a.has(SteeringBit);
+		for (int i = 0; i < a.size(); i++) {
+			Vector2 position = a.positions[i].value;
+			float closestSq = playerPositions.empty() ? 0.0f : INFINITY;
+			for (Vector2 player : playerPositions)
+				closestSq = fminf(closestSq, Vector2DistanceSqr(position, player));
+
+			int level = FullLod;
+			while (level < AiLodLevelCount - 1 && closestSq > lodDistances[level] * lodDistances[level])
+				level++;
+
+			bool idle = Vector2LengthSqr(a.velocities[i].value) < idleSpeed * idleSpeed
+				&& (!steered || Vector2LengthSqr(a.steerings[i].targetVelocity) < idleSpeed * idleSpeed);
+			if (idle) {
+				level = EighthLod;
+				idleCount++;
+			}
+
+			AiLod& lod = a.aiLods[i];
+			lod.level = level;
+			int period = 1 << level;
+			lod.due = ((tick + lod.phase) & (period - 1)) == 0;
+			levelCounts[level]++;
+			dueCount += lod.due;
+		}
+	});
+}
+
+void drawAiLodStats(int x, int y) {
+	DrawText(TextFormat("AI LOD (L to toggle): every tick %d, 2nd %d, 4th %d, 8th %d (%d idle), %d steered this tick",
+		levelCounts[FullLod], levelCounts[HalfLod], levelCounts[QuarterLod], levelCounts[EighthLod], idleCount, dueCount), x, y, 20, RED);
+}
+
+const System AiLodPhase = { "aiLod", aiLodSystem, PositionBit | VelocityBit | PlayerInputBit | SteeringBit, AiLodBit, NoSystemFlags };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// AI level of detail for agents with an AiLod component.
+// Agents close to the player steer every tick, further out every 2nd, 4th or 8th tick, and agents that are idle
+// (Stopped with a target that isn't moving, like Arrive once it's there) drop straight to the lowest rate.
+// The ticks an agent is due on are staggered by its phase so a level's agents don't all update on the same tick.
+// In between, steeringSystem just carries the agent along its velocity, and on its next update the steering
+// Gets to turn and accelerate for all the ticks it missed at once.
+// There's no camera here (The screen is the whole world), so distance to the player is the only distance used.
+enum AiLodLevel {
+	FullLod,
+	HalfLod,
+	QuarterLod,
+	EighthLod,
+	AiLodLevelCount,
+};
+
+// Picks every AiLod agent's level and whether it's due this tick
+void aiLodSystem(World& world);
+void drawAiLodStats(int x, int y);
+
+extern const System AiLodPhase;
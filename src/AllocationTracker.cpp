@@ -0,0 +1,233 @@
+#include "raylib.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#include "AllocationTracker.h"
+
+// Everything in here has to be constant initialized and must never allocate itself,
+// Since operator new can be called before main() and from inside the tracker
+static std::atomic<size_t> frameCount{ 0 };
+static std::atomic<size_t> frameBytes{ 0 };
+static std::atomic<size_t> frameFrees{ 0 };
+static std::atomic<size_t> totalCount{ 0 };
+static std::atomic<size_t> totalBytes{ 0 };
+static std::atomic<size_t> totalFrees{ 0 };
+
+static FrameAllocationStats previousFrame = { 0, 0, 0 };
+static std::atomic<bool> frameRunning{ false };
+static std::atomic<int> framesSinceTransition{ 0 };
+
+static std::mutex siteMutex;
+static AllocationSite sites[AllocationTracker::maxSites];
+static int siteCount = 0;
+static const char* const untaggedSite = "untagged";
+
+static thread_local const char* currentSite = nullptr;
+
+static void recordAllocation(size_t size) {
+	frameCount.fetch_add(1, std::memory_order_relaxed);
+	frameBytes.fetch_add(size, std::memory_order_relaxed);
+	totalCount.fetch_add(1, std::memory_order_relaxed);
+	totalBytes.fetch_add(size, std::memory_order_relaxed);
+
+	const char* siteName = currentSite ? currentSite : untaggedSite;
+	{
+		std::lock_guard<std::mutex> lock(siteMutex);
+		int i = 0;
+		// Sites are string literals so comparing pointers is enough
+		for (; i < siteCount; i++) {
+			if (sites[i].name == siteName)
+				break;
+		}
+		if (i == siteCount && siteCount < AllocationTracker::maxSites) {
+			sites[i] = AllocationSite{ siteName, 0, 0, 0, 0 };
+			siteCount++;
+		}
+		if (i < siteCount) {
+			sites[i].frameCount++;
+			sites[i].frameBytes += size;
+			sites[i].totalCount++;
+			sites[i].totalBytes += size;
+		}
+	}
+
+#if ALLOCATION_ASSERTS
+	if (AllocationTracker::isSteadyState()) {
+		fprintf(stderr, "Heap allocation of %zu bytes in steady state (site: %s)\n", size, siteName);
+		assert(!"Steady state frame allocated, see AllocationTracker.h");
+	}
+#endif
+}
+
+static void recordFree(void* ptr) {
+	if (!ptr)
+		return;
+	frameFrees.fetch_add(1, std::memory_order_relaxed);
+	totalFrees.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void* trackedAllocate(size_t size) {
+	if (size == 0)
+		size = 1;
+	void* ptr = std::malloc(size);
+	if (ptr)
+		recordAllocation(size);
+	return ptr;
+}
+
+// Replacements for the global allocation functions,
+// the aligned (std::align_val_t) overloads are left to the standard library and aren't counted
+void* operator new(size_t size) {
+	void* ptr = trackedAllocate(size);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size) {
+	void* ptr = trackedAllocate(size);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return trackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return trackedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+void AllocationTracker::beginFrame() {
+	frameCount.store(0, std::memory_order_relaxed);
+	frameBytes.store(0, std::memory_order_relaxed);
+	frameFrees.store(0, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(siteMutex);
+		for (int i = 0; i < siteCount; i++) {
+			sites[i].frameCount = 0;
+			sites[i].frameBytes = 0;
+		}
+	}
+	frameRunning.store(true, std::memory_order_relaxed);
+}
+
+void AllocationTracker::endFrame() {
+	frameRunning.store(false, std::memory_order_relaxed);
+	previousFrame.count = frameCount.load(std::memory_order_relaxed);
+	previousFrame.bytes = frameBytes.load(std::memory_order_relaxed);
+	previousFrame.frees = frameFrees.load(std::memory_order_relaxed);
+
+	if (framesSinceTransition.load(std::memory_order_relaxed) < warmupFrames)
+		framesSinceTransition.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::markTransition() {
+	framesSinceTransition.store(0, std::memory_order_relaxed);
+}
+
+bool AllocationTracker::isSteadyState() {
+	return frameRunning.load(std::memory_order_relaxed)
+		&& framesSinceTransition.load(std::memory_order_relaxed) >= warmupFrames;
+}
+
+FrameAllocationStats AllocationTracker::lastFrame() {
+	return previousFrame;
+}
+
+FrameAllocationStats AllocationTracker::total() {
+	return FrameAllocationStats{
+		totalCount.load(std::memory_order_relaxed),
+		totalBytes.load(std::memory_order_relaxed),
+		totalFrees.load(std::memory_order_relaxed)
+	};
+}
+
+int AllocationTracker::topSites(AllocationSite* outSites, int maxOut) {
+	std::lock_guard<std::mutex> lock(siteMutex);
+	int written = 0;
+	// Insertion into a small sorted output, the site table is tiny
+	for (int i = 0; i < siteCount; i++) {
+		if (sites[i].frameCount == 0)
+			continue;
+
+		int j;
+		if (written < maxOut)
+			j = written++;
+		else if (maxOut > 0 && outSites[maxOut - 1].frameBytes < sites[i].frameBytes)
+			j = maxOut - 1;
+		else
+			continue;
+
+		outSites[j] = sites[i];
+		while (j > 0 && outSites[j - 1].frameBytes < outSites[j].frameBytes) {
+			AllocationSite tmp = outSites[j - 1];
+			outSites[j - 1] = outSites[j];
+			outSites[j] = tmp;
+			j--;
+		}
+	}
+	return written;
+}
+
+void AllocationTracker::drawOverlay(int x, int y) {
+	FrameAllocationStats frame = lastFrame();
+	FrameAllocationStats all = total();
+	Color color = frame.count == 0 ? GREEN : RED;
+
+	// TextFormat uses raylib's static buffers, so drawing this doesn't allocate
+	DrawText(TextFormat("Allocations last frame: %zu (%zu bytes), frees: %zu", frame.count, frame.bytes, frame.frees), x, y, 20, color);
+	DrawText(TextFormat("Allocations total: %zu (%zu bytes), frees: %zu", all.count, all.bytes, all.frees), x, y + 25, 20, GRAY);
+
+	AllocationSite top[3];
+	int topCount = topSites(top, 3);
+	for (int i = 0; i < topCount; i++) {
+		DrawText(TextFormat("  %s: %zu allocs, %zu bytes", top[i].name, top[i].frameCount, top[i].frameBytes),
+			x, y + 50 + i * 25, 20, color);
+	}
+}
+
+AllocationScope::AllocationScope(const char* siteName) {
+	previous = currentSite;
+	currentSite = siteName;
+}
+
+AllocationScope::~AllocationScope() {
+	currentSite = previous;
+}
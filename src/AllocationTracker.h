@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts every heap allocation that goes through operator new (see AllocationTracker.cpp)
+// The sim should reach a steady state where a frame allocates nothing at all,
+// Things like switching behavior or scenario are allowed to allocate, the hot loop is not.
+//
+// Since there's no portable way of grabbing a callstack inside operator new,
+// "call sites" are named scopes instead: put TRACK_ALLOCATIONS("name") at the top of a function
+// And anything allocated inside it (and below it) gets booked to that name.
+
+// Assertion mode is on in Debug builds (premake defines DEBUG there)
+// Define NO_ALLOCATION_ASSERTS to only count without failing
+#if defined(DEBUG) && !defined(NO_ALLOCATION_ASSERTS)
+#define ALLOCATION_ASSERTS 1
+#else
+#define ALLOCATION_ASSERTS 0
+#endif
+
+struct AllocationSite {
+	const char* name;
+	size_t frameCount;
+	size_t frameBytes;
+	size_t totalCount;
+	size_t totalBytes;
+};
+
+struct FrameAllocationStats {
+	size_t count;
+	size_t bytes;
+	size_t frees;
+};
+
+struct AllocationTracker {
+	static constexpr int maxSites = 32;
+	// Frames that have to pass after a transition before we expect zero allocations
+	static constexpr int warmupFrames = 3;
+
+	static void beginFrame();
+	static void endFrame();
+
+	// Call this whenever the sim legitimately changes state (scenario switch, behavior switch etc.)
+	// It restarts the warmup so the next few frames may allocate without failing the assertion
+	static void markTransition();
+	static bool isSteadyState();
+
+	static FrameAllocationStats lastFrame();
+	static FrameAllocationStats total();
+
+	// Fills outSites with up to maxOut sites ordered by bytes allocated last frame, returns the count
+	static int topSites(AllocationSite* outSites, int maxOut);
+
+	static void drawOverlay(int x, int y);
+};
+
+// RAII tag, see TRACK_ALLOCATIONS below
+struct AllocationScope {
+	const char* previous;
+	AllocationScope(const char* siteName);
+	~AllocationScope();
+};
+
+#define ALLOCATION_SCOPE_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_SCOPE_CONCAT(a, b) ALLOCATION_SCOPE_CONCAT_INNER(a, b)
+#define TRACK_ALLOCATIONS(siteName) AllocationScope ALLOCATION_SCOPE_CONCAT(_allocationScope, __LINE__)(siteName)
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Scenario scoped memory.
+// Each composed scenario owns one ScenarioArena, and everything the scenario spawns
+// (agents, objects, players, pads) is carved out of it, so the object graph sits in a few contiguous blocks.
+// Instead of matching every new with a delete, the whole graph is torn down with a single reset().
+struct ScenarioArena {
+	struct Block {
+		Block* next;
+		size_t size;
+		size_t used;
+	};
+
+	// Destructors of non trivial objects are remembered in a list that also lives in the arena
+	struct Finalizer {
+		void (*destroy)(void*);
+		void* object;
+		Finalizer* next;
+	};
+
+	Block* firstBlock;
+	Block* currentBlock;
+	Finalizer* finalizers;
+	size_t blockSize;
+
+	ScenarioArena(size_t _blockSize = 16 * 1024)
+		: firstBlock(nullptr), currentBlock(nullptr), finalizers(nullptr), blockSize(_blockSize) {
+	}
+
+	~ScenarioArena() {
+		reset();
+		Block* block = firstBlock;
+		while (block) {
+			Block* next = block->next;
+			::operator delete(block);
+			block = next;
+		}
+	}
+
+	ScenarioArena(const ScenarioArena&) = delete;
+	ScenarioArena& operator=(const ScenarioArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment) {
+		// Walk forward through blocks we already own (after a reset) before asking for new memory
+		while (currentBlock) {
+			void* ptr = tryAllocate(currentBlock, size, alignment);
+			if (ptr)
+				return ptr;
+			if (!currentBlock->next)
+				break;
+			currentBlock = currentBlock->next;
+			currentBlock->used = 0;
+		}
+
+		size_t needed = size + alignment;
+		Block* block = newBlock(needed > blockSize ? needed : blockSize);
+		if (currentBlock) {
+			block->next = currentBlock->next;
+			currentBlock->next = block;
+		}
+		else {
+			firstBlock = block;
+		}
+		currentBlock = block;
+		return tryAllocate(block, size, alignment);
+	}
+
+	template<typename T, typename... Args>
+	T* create(Args&&... args) {
+		void* memory = allocate(sizeof(T), alignof(T));
+		T* object = new (memory) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value)
+			addFinalizer(object, [](void* ptr) { static_cast<T*>(ptr)->~T(); });
+		return object;
+	}
+
+	template<typename T>
+	T* createArray(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "createArray is only for plain data");
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	void addFinalizer(void* object, void (*destroy)(void*)) {
+		Finalizer* finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+		finalizer->destroy = destroy;
+		finalizer->object = object;
+		finalizer->next = finalizers;
+		finalizers = finalizer;
+	}
+
+	// Destroys everything in reverse creation order and rewinds to the first block.
+	// The blocks are kept so rebuilding the scenario doesn't touch the heap again.
+	void reset() {
+		while (finalizers) {
+			Finalizer* finalizer = finalizers;
+			finalizers = finalizer->next;
+			finalizer->destroy(finalizer->object);
+		}
+		currentBlock = firstBlock;
+		if (currentBlock)
+			currentBlock->used = 0;
+	}
+
+	size_t bytesReserved() const {
+		size_t total = 0;
+		for (Block* block = firstBlock; block; block = block->next)
+			total += block->size;
+		return total;
+	}
+
+private:
+	static char* blockData(Block* block) {
+		return reinterpret_cast<char*>(block) + sizeof(Block);
+	}
+
+	static void* tryAllocate(Block* block, size_t size, size_t alignment) {
+		uintptr_t base = reinterpret_cast<uintptr_t>(blockData(block));
+		uintptr_t start = (base + block->used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		if (start + size > base + block->size)
+			return nullptr;
+		block->used = start + size - base;
+		return reinterpret_cast<void*>(start);
+	}
+
+	static Block* newBlock(size_t size) {
+		Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+		block->next = nullptr;
+		block->size = size;
+		block->used = 0;
+		return block;
+	}
+};
+
+// Typed free list on top of an arena.
+// All slots are carved out of the arena up front, so spawn and despawn are O(1) and never call malloc.
+// Despawned slots go back on the free list and get reused by the next spawn.
+template<typename T>
+struct Pool {
+	union Slot {
+		Slot* nextFree;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	Slot* slots;
+	bool* alive;
+	Slot* freeList;
+	int capacity;
+	int liveCount;
+
+	Pool(ScenarioArena& arena, int _capacity)
+		: capacity(_capacity), liveCount(0) {
+		slots = arena.createArray<Slot>(capacity);
+		alive = arena.createArray<bool>(capacity);
+		freeList = nullptr;
+		// Build the free list backwards so the first spawn gets slot 0
+		for (int i = capacity - 1; i >= 0; i--) {
+			alive[i] = false;
+			slots[i].nextFree = freeList;
+			freeList = &slots[i];
+		}
+	}
+
+	// The arena runs this on reset, anything still alive is destroyed here
+	~Pool() {
+		for (int i = 0; i < capacity; i++) {
+			if (alive[i])
+				reinterpret_cast<T*>(slots[i].storage)->~T();
+		}
+	}
+
+	Pool(const Pool&) = delete;
+	Pool& operator=(const Pool&) = delete;
+
+	// Returns nullptr when the pool is full instead of falling back to the heap
+	template<typename... Args>
+	T* spawn(Args&&... args) {
+		if (!freeList)
+			return nullptr;
+		Slot* slot = freeList;
+		freeList = slot->nextFree;
+		alive[slot - slots] = true;
+		liveCount++;
+		return new (slot->storage) T(std::forward<Args>(args)...);
+	}
+
+	void despawn(T* object) {
+		if (!object)
+			return;
+		Slot* slot = reinterpret_cast<Slot*>(object);
+		object->~T();
+		alive[slot - slots] = false;
+		slot->nextFree = freeList;
+		freeList = slot;
+		liveCount--;
+	}
+
+	bool full() const {
+		return freeList == nullptr;
+	}
+};
@@ -0,0 +1,122 @@
+#include <cassert>
+
+#include "BehaviorTree.h"
+
+static bool evaluate(const BtNode* nodes, int index, const Blackboard& blackboard, Behaviors& chosen, int& visited) {
+	const BtNode& node = nodes[index];
+	visited++;
+
+	switch (node.type) {
+	case BtSelectorNode:
+		for (int child = index + 1; child < node.end; child = nodes[child].end) {
+			if (evaluate(nodes, child, blackboard, chosen, visited))
+				return true;
+		}
+		return false;
+	case BtSequenceNode:
+		for (int child = index + 1; child < node.end; child = nodes[child].end) {
+			if (!evaluate(nodes, child, blackboard, chosen, visited))
+				return false;
+		}
+		return true;
+	case BtInverterNode:
+		return !evaluate(nodes, index + 1, blackboard, chosen, visited);
+	case BtConditionNode:
+		switch (node.condition) {
+		case BtHasTarget: return blackboard.hasTarget;
+		case BtTargetCloserThan: return blackboard.hasTarget && blackboard.targetDistance < node.threshold;
+		case BtTargetFasterThan: return blackboard.hasTarget && blackboard.targetSpeed > node.threshold;
+		case BtTicksInBehaviorAtLeast: return blackboard.ticksInBehavior >= node.threshold;
+		case BtBehaviorIs: return blackboard.behavior == node.behavior;
+		default: return false;
+		}
+	case BtActionNode:
+		chosen = (Behaviors)node.behavior;
+		return true;
+	default:
+		return false;
+	}
+}
+
+Behaviors BehaviorTree::tick(const Blackboard& blackboard, int& nodesVisited) const {
+	Behaviors chosen = (Behaviors)blackboard.behavior;
+	if (!nodes.empty())
+		evaluate(nodes.data(), 0, blackboard, chosen, nodesVisited);
+	return chosen;
+}
+
+void BehaviorTreeBuilder::push(BtNode node, bool composite) {
+	node.end = tree.nodes.size() + 1;
+	tree.nodes.push_back(node);
+	if (composite)
+		open.push_back(tree.nodes.size() - 1);
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::selector() {
+	push(BtNode{ BtSelectorNode }, true);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::sequence() {
+	push(BtNode{ BtSequenceNode }, true);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::inverter() {
+	push(BtNode{ BtInverterNode }, true);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::condition(BtCondition condition, float threshold) {
+	push(BtNode{ BtConditionNode, condition, 0, 0, threshold }, false);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::behaviorIs(Behaviors behavior) {
+	push(BtNode{ BtConditionNode, BtBehaviorIs, (uint8_t)behavior }, false);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::action(Behaviors behavior) {
+	push(BtNode{ BtActionNode, BtHasTarget, (uint8_t)behavior }, false);
+	return *this;
+}
+
+// Closing a composite is the point where we know how far its subtree goes
+BehaviorTreeBuilder& BehaviorTreeBuilder::end() {
+	assert(!open.empty() && "end() without an open composite");
+	tree.nodes[open.back()].end = tree.nodes.size();
+	open.pop_back();
+	return *this;
+}
+
+BehaviorTree BehaviorTreeBuilder::build() {
+	assert(open.empty() && "Every composite needs an end()");
+	return tree;
+}
+
+const BehaviorTree& behaviorTree(BehaviorTreeId id) {
+	static BehaviorTree trees[BehaviorTreeCount] = {
+		BehaviorTreeBuilder()
+			.selector()
+				.sequence().condition(BtTargetCloserThan, 80.0f).action(Flee).end()
+				.sequence().condition(BtTargetCloserThan, 400.0f)
+					.selector()
+						// Hold on to pursue for a bit once the target slows down, instead of flipping every tick
+						.sequence().condition(BtTargetFasterThan, 1.0f).action(Pursue).end()
+						.sequence().behaviorIs(Pursue).inverter().condition(BtTicksInBehaviorAtLeast, 30.0f).end().action(Pursue).end()
+						.action(Arrive)
+					.end()
+				.end()
+				.action(Wander)
+			.end()
+			.build(),
+		BehaviorTreeBuilder()
+			.selector()
+				.sequence().condition(BtTargetCloserThan, 250.0f).action(Evade).end()
+				.action(Wander)
+			.end()
+			.build(),
+	};
+	return trees[id];
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Agent.h"
+
+// Behavior trees for picking a Behaviors value on their own, instead of the key presses in Agent::displayDebug.
+// A tree is compiled into one flat array of nodes in depth first order, where every node knows where its subtree ends.
+// So the first child of a composite is the next node and the next sibling is at children[i].end, no pointers at all.
+// Ticking is a switch over the node type (No virtual calls), and everything an agent's tree looks at
+// Sits in its small Blackboard, so thousands of agents tick without allocating anything.
+//
+// Actions only pick a behavior and always succeed, so there's no "running" state to remember between ticks:
+// Every tick starts at the root and the first action reached decides.
+
+enum BtNodeType : uint8_t {
+	// Succeeds on the first child that succeeds
+	BtSelectorNode,
+	// Fails on the first child that fails
+	BtSequenceNode,
+	// One child, flips its result
+	BtInverterNode,
+	BtConditionNode,
+	BtActionNode,
+};
+
+enum BtCondition : uint8_t {
+	BtHasTarget,
+	BtTargetCloserThan,
+	BtTargetFasterThan,
+	// How long the current behavior has been picked for, to stop trees flickering between two
+	BtTicksInBehaviorAtLeast,
+	BtBehaviorIs,
+};
+
+struct BtNode {
+	BtNodeType type;
+	BtCondition condition;
+	// For actions and BtBehaviorIs
+	uint8_t behavior;
+	// One past the last node of this subtree
+	uint16_t end;
+	float threshold;
+};
+
+// What a tree can see of its agent, filled in right before the tick
+struct Blackboard {
+	float targetDistance = 0.0f;
+	float targetSpeed = 0.0f;
+	bool hasTarget = false;
+	uint8_t behavior = Seek;
+	uint16_t ticksInBehavior = 0;
+};
+
+struct BehaviorTree {
+	std::vector<BtNode> nodes;
+
+	// Returns the behavior the tree picked, or the current one if no action was reached.
+	// nodesVisited is added to for the stats
+	Behaviors tick(const Blackboard& blackboard, int& nodesVisited) const;
+};
+
+// Builds the flat array. Composites are opened, filled with children and closed with end():
+//   builder.selector(); builder.sequence(); builder.condition(BtTargetCloserThan, 100); builder.action(Flee); builder.end(); builder.end();
+struct BehaviorTreeBuilder {
+	BehaviorTree tree;
+	std::vector<int> open;
+
+	BehaviorTreeBuilder& selector();
+	BehaviorTreeBuilder& sequence();
+	BehaviorTreeBuilder& inverter();
+	BehaviorTreeBuilder& condition(BtCondition condition, float threshold = 0.0f);
+	BehaviorTreeBuilder& behaviorIs(Behaviors behavior);
+	BehaviorTreeBuilder& action(Behaviors behavior);
+	BehaviorTreeBuilder& end();
+	BehaviorTree build();
+
+private:
+	void push(BtNode node, bool composite);
+};
+
+enum BehaviorTreeId : uint8_t {
+	// Keeps some distance, pursues a moving target, arrives at a still one, wanders without one
+	ScoutTree,
+	// Evades anything that comes close, wanders otherwise
+	SkittishTree,
+	BehaviorTreeCount,
+};
+
+// The compiled trees, built the first time this is called
+const BehaviorTree& behaviorTree(BehaviorTreeId id);
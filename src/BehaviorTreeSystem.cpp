@@ -0,0 +1,91 @@
+#include <atomic>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "BehaviorTreeSystem.h"
+#include "ThreadPool.h"
+
+// From the last tick, for the overlay
+static int agentsTicked = 0;
+static int nodesVisited = 0;
+static int behaviorsSwitched = 0;
+
+struct BehaviorTreeJob {
+	Archetype* archetype;
+	// The archetype row parallelFor's index 0 stands for
+	int first;
+	std::atomic<int> ticked;
+	std::atomic<int> nodesVisited;
+	std::atomic<int> switched;
+};
+
+static void tickAgents(void* data, int begin, int end) {
+	BehaviorTreeJob& job = *(BehaviorTreeJob*)data;
+	Archetype& a = *job.archetype;
+	bool sleeps = a.has(SleepBit);
+	int ticked = 0;
+	int visited = 0;
+	int switched = 0;
+
+	for (int i = job.first + begin; i < job.first + end; i++) {
+		if (sleeps && a.sleeps[i].asleep)
+			continue;
+		ticked++;
+		Steering& steering = a.steerings[i];
+		BehaviorTreeAgent& agent = a.behaviorTrees[i];
+		Blackboard& blackboard = agent.blackboard;
+		blackboard.hasTarget = steering.hasTarget;
+		blackboard.targetDistance = Vector2Distance(a.positions[i].value, steering.targetPosition);
+		blackboard.targetSpeed = Vector2Length(steering.targetVelocity);
+		blackboard.behavior = steering.behavior;
+
+		Behaviors chosen = behaviorTree(agent.tree).tick(blackboard, visited);
+		if (chosen != steering.behavior) {
+			// Same as Agent::setBehavior, a new behavior starts from fresh state
+			steering.behavior = chosen;
+			steering.state = AgentBehaviorState();
+			blackboard.behavior = chosen;
+			blackboard.ticksInBehavior = 0;
+			switched++;
+		}
+		else if (blackboard.ticksInBehavior < UINT16_MAX)
+			blackboard.ticksInBehavior++;
+	}
+
+	job.ticked += ticked;
+	job.nodesVisited += visited;
+	job.switched += switched;
+}
+
+// One batch of the time slice, still split over the thread pool
+static void serviceAgents(void* data, int begin, int end) {
+	World& world = *(World*)data;
+	forEachRowRange(world, PositionBit | SteeringBit | BehaviorTreeBit, begin, end, [](Archetype& a, int from, int to) {
+		BehaviorTreeJob job = { &a, from, { 0 }, { 0 }, { 0 } };
+		ThreadPool::instance().parallelFor(to - from, 64, tickAgents, &job);
+		agentsTicked += job.ticked;
+		nodesVisited += job.nodesVisited;
+		behaviorsSwitched += job.switched;
+	});
+}
+
+void behaviorTreeSystem(World& world) {
+	agentsTicked = 0;
+	nodesVisited = 0;
+	behaviorsSwitched = 0;
+
+	int count = 0;
+	world.forEachArchetype(PositionBit | SteeringBit | BehaviorTreeBit, [&count](Archetype& a) {
+		count += a.size();
+	});
+	// Agents the budget doesn't get to keep their behavior until their turn comes
+	world.aiSlices[BehaviorTreeSubsystem].run(world.tick, count, 256, serviceAgents, &world);
+}
+
+void drawBehaviorTreeStats(int x, int y) {
+	DrawText(TextFormat("Behavior trees (U for utility AI): %d agents ticked, %.1f nodes per agent, %d switched behavior",
+		agentsTicked, agentsTicked > 0 ? (float)nodesVisited / agentsTicked : 0.0f, behaviorsSwitched), x, y, 20, RED);
+}
+
+const System BehaviorTreePhase = { "behaviorTree", behaviorTreeSystem, PositionBit | SleepBit, SteeringBit | BehaviorTreeBit, NoSystemFlags };
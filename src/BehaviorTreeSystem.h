@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// Ticks the behavior tree of every BehaviorTreeAgent and writes the pick into Steering::behavior.
+// Runs after targetSystem so the blackboards see this frame's target. Agents are split over the
+// Thread pool, they don't read each other so no chunk has to wait on another.
+// With a budget on World::aiSlices[BehaviorTreeSubsystem] only as many as fit in it tick (TimeSlicer.h).
+void behaviorTreeSystem(World& world);
+void drawBehaviorTreeStats(int x, int y);
+
+extern const System BehaviorTreePhase;
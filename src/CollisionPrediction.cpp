@@ -0,0 +1,126 @@
+#include "CollisionPrediction.h"
+
+void CollisionPredictor::reserve(int maxAgents) {
+	positionX.reserve(maxAgents);
+	positionY.reserve(maxAgents);
+	velocityX.reserve(maxAgents);
+	velocityY.reserve(maxAgents);
+	radius.reserve(maxAgents);
+	avoidance.reserve(maxAgents);
+	grid.reserve(maxAgents);
+}
+
+// One batch of neighbours in plain float arrays. The loop has no branches and no calls, so the compiler
+// Can run it several lanes at a time, and the branchy part (picking the earliest) happens afterwards
+struct PredictionBatch {
+	float relativeX[CollisionPredictor::maxCandidates];
+	float relativeY[CollisionPredictor::maxCandidates];
+	float relativeVX[CollisionPredictor::maxCandidates];
+	float relativeVY[CollisionPredictor::maxCandidates];
+	float minimumDistance[CollisionPredictor::maxCandidates];
+	// Outputs: time of closest approach, or a big number if they never get too close within the horizon
+	float collisionTime[CollisionPredictor::maxCandidates];
+	float closestX[CollisionPredictor::maxCandidates];
+	float closestY[CollisionPredictor::maxCandidates];
+};
+
+static void predictBatch(PredictionBatch& b, int count, float horizon) {
+	const float never = 1e30f;
+	for (int n = 0; n < count; n++) {
+		float speedSq = b.relativeVX[n] * b.relativeVX[n] + b.relativeVY[n] * b.relativeVY[n];
+		// t = -(dp . dv) / |dv|^2, kept inside [0, horizon]
+		float t = -(b.relativeX[n] * b.relativeVX[n] + b.relativeY[n] * b.relativeVY[n]) / fmaxf(speedSq, 0.0001f);
+		t = fminf(fmaxf(t, 0.0f), horizon);
+
+		float closestX = b.relativeX[n] + b.relativeVX[n] * t;
+		float closestY = b.relativeY[n] + b.relativeVY[n] * t;
+		float separationSq = closestX * closestX + closestY * closestY;
+		float limitSq = b.minimumDistance[n] * b.minimumDistance[n];
+
+		b.collisionTime[n] = separationSq < limitSq ? t : never;
+		b.closestX[n] = closestX;
+		b.closestY[n] = closestY;
+	}
+}
+
+struct EarliestCollision {
+	float time;
+	Vector2 away;
+};
+
+// Predicts a batch and keeps whichever collision in it is earlier than the one so far
+static void predictEarliest(PredictionBatch& b, int count, float horizon, EarliestCollision& earliest) {
+	predictBatch(b, count, horizon);
+	for (int n = 0; n < count; n++) {
+		if (b.collisionTime[n] >= earliest.time)
+			continue;
+		earliest.time = b.collisionTime[n];
+		// Already too close (t == 0) means steer away from where it is now, otherwise from where it will be
+		earliest.away = { -b.closestX[n], -b.closestY[n] };
+		if (Vector2LengthSqr(earliest.away) < 0.0001f)
+			earliest.away = { -b.relativeX[n], -b.relativeY[n] };
+	}
+}
+
+int CollisionPredictor::apply(std::vector<Agent*>& agents, float minimumDistanceScale) {
+	int count = agents.size();
+	positionX.resize(count);
+	positionY.resize(count);
+	velocityX.resize(count);
+	velocityY.resize(count);
+	radius.resize(count);
+	avoidance.resize(count);
+
+	float maxSpeed = 0.0f;
+	float maxRadius = 0.0f;
+	for (int i = 0; i < count; i++) {
+		positionX[i] = agents[i]->position.x;
+		positionY[i] = agents[i]->position.y;
+		velocityX[i] = agents[i]->velocity.x;
+		velocityY[i] = agents[i]->velocity.y;
+		radius[i] = agents[i]->radius;
+		maxSpeed = fmaxf(maxSpeed, agents[i]->speed);
+		maxRadius = fmaxf(maxRadius, radius[i]);
+	}
+
+	// Nothing further away than this can close the gap within the horizon, even head on at full speed
+	float reach = 2.0f * maxSpeed * horizon + 2.0f * maxRadius * minimumDistanceScale;
+	grid.build(positionX.data(), positionY.data(), count, reach);
+
+	PredictionBatch batch;
+	avoidedThisFrame = 0;
+	for (int i = 0; i < count; i++) {
+		float x = positionX[i];
+		float y = positionY[i];
+		// Reach covers most of a crowd, so every candidate gets checked, a full batch at a time,
+		// And only the earliest collision so far is carried over between batches
+		EarliestCollision earliest = { horizon + 1.0f, { 0, 0 } };
+		int candidates = 0;
+		grid.forEachCandidate(x, y, reach, [&](int other) {
+			if (other == i)
+				return;
+			// Relative to this agent, the other one's position and velocity
+			batch.relativeX[candidates] = positionX[other] - x;
+			batch.relativeY[candidates] = positionY[other] - y;
+			batch.relativeVX[candidates] = velocityX[other] - velocityX[i];
+			batch.relativeVY[candidates] = velocityY[other] - velocityY[i];
+			batch.minimumDistance[candidates] = (radius[i] + radius[other]) * minimumDistanceScale;
+			if (++candidates == maxCandidates) {
+				predictEarliest(batch, candidates, horizon, earliest);
+				candidates = 0;
+			}
+		});
+		predictEarliest(batch, candidates, horizon, earliest);
+
+		avoidance[i] = Vector2{ 0, 0 };
+		if (earliest.time > horizon)
+			continue;
+		avoidance[i] = Vector2Normalize(earliest.away) * maxAvoidance;
+		avoidedThisFrame++;
+	}
+
+	// Applied after every prediction so they all saw the same velocities
+	for (int i = 0; i < count; i++)
+		agents[i]->velocity = Vector2ClampValue(agents[i]->velocity + avoidance[i], 0.0f, agents[i]->speed);
+	return avoidedThisFrame;
+}
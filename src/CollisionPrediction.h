@@ -0,0 +1,39 @@
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <vector>
+
+#include "Agent.h"
+#include "SpatialGrid.h"
+
+// Predictive avoidance for SeparatedAgents.
+// handleCollision only pushes agents apart once they already overlap. This looks ahead instead:
+// For every neighbour within reach of the horizon it works out the time of closest approach assuming both keep
+// Their velocity, and if they would come closer than the minimum distance the agent steers away from the
+// Most imminent of those (Millington's collision avoidance, but against every neighbour rather than one target).
+struct CollisionPredictor {
+	// Frames to look ahead, velocities are per frame
+	float horizon = 40.0f;
+	// Has to beat the 0.2 the behaviors steer with each update, otherwise seek just steers it straight back
+	float maxAvoidance = 0.8f;
+	// Neighbours predicted per batch, an agent with more goes through several
+	static constexpr int maxCandidates = 32;
+
+	SpatialGrid grid;
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> radius;
+	std::vector<Vector2> avoidance;
+
+	// Shown in the overlay
+	int avoidedThisFrame = 0;
+
+	void reserve(int maxAgents);
+	// minimumDistanceScale turns the sum of radii into the distance that counts as a collision,
+	// Same as getMinDistance. Returns how many agents steered away from something
+	int apply(std::vector<Agent*>& agents, float minimumDistanceScale);
+};
@@ -6,62 +6,77 @@
 #include "memory.h"
 #include <vector>
 #include "ComposedAgents.h"
+#include "AllocationTracker.h"
+#include "Random.h"
 
 PathfollowAgent::PathfollowAgent(int _maximumPathCount) {
 	width = GetScreenWidth();
 	height = GetScreenHeight();
-	agent = new Agent(Vector2{ width / 2, height / 6 }, 15.0f, 5.0f, 0, 0.1f, true);
-	obj = new Object(Vector2{ width / 2, height / 4 }, 25.0f, 5.0f);
+	agent = arena.create<Agent>(Vector2{ width / 2, height / 6 }, 15.0f, 5.0f, 0, 0.1f, true);
+	obj = arena.create<Object>(Vector2{ width / 2, height / 4 }, 25.0f, 5.0f);
 	maximumPathCount = _maximumPathCount;
-	agent->behaviorImpl = std::make_unique<SeekBehavior>();
+	// clear() keeps the capacity, so regenerating the path never has to grow the vector again
+	nodePositions.reserve(maximumPathCount);
+	agent->behaviorImpl = getBehaviorInstance(Seek);
+	script = followPaths();
+	script.start();
 }
 
+// agent, obj and the script's frame are released when the arena resets
 PathfollowAgent::~PathfollowAgent() {
-	delete agent;
-	delete obj;
+	script.stop();
+	arena.reset();
 }
 
 void PathfollowAgent::update() {
-	generateNewPath();
+	scripts.update();
 	updatePathFollowAgent();
 	obj->drawShape();
 	debugDraw();
+	DrawText(TextFormat("Path script (coroutine): node %d/%d, %d arrivals so far%s", currentNodeIndex + 1, (int)nodePositions.size(), arrived.fired,
+		scripts.timers.pending() == 0 ? "" : ", pausing"), 10, GetScreenHeight() - 80, 20, RED);
+}
+
+// Same steps the old per frame checks went through, just written in the order they happen
+AgentScript PathfollowAgent::followPaths() {
+	while (true) {
+		generateNewPath();
+		for (currentNodeIndex = 0; currentNodeIndex < nodePositions.size(); currentNodeIndex++) {
+			obj->position = nodePositions[currentNodeIndex];
+			co_await arrived;
+		}
+		currentNodeIndex = nodePositions.size() - 1;
+		co_await scripts.wait(pauseTicks);
+		nodePositions.clear();
+	}
 }
 
 void PathfollowAgent::generateNewPath() {
+	TRACK_ALLOCATIONS("PathfollowAgent::generateNewPath");
 	if (nodePositions.empty()) {
+		uint64_t key = randomKey(agent->id);
 		for (int i = 0; i < maximumPathCount; i++) {
-			float x = GetRandomValue(0, width);
-			float y = GetRandomValue(0, height);
+			float x = randomRange(key, randomCounter(pathsGenerated, i * 2), 0, width);
+			float y = randomRange(key, randomCounter(pathsGenerated, i * 2 + 1), 0, height);
 			nodePositions.push_back(Vector2{ x, y });
 		}
+		pathsGenerated++;
 		currentNodeIndex = 0;
 		if (!nodePositions.empty()) obj->position = nodePositions[0];
 	}
 }
 
-// I realized that since i am using unique pointer, that setting seek = std::make_unique<SeekBehavior>()
-// In the constructor would mean I need to use move() and thus now seek is equal nullptr and useless.
-// The ideal solution would be to use shared pointer or copy it as a raw pointer (Tedious) --
-// but that's beyond the scope of this assignment.
+// Behaviors are shared instances now (getBehaviorInstance), so the agent just points at the seek one.
+// obj always sits on the node the script is waiting to reach
 void PathfollowAgent::updatePathFollowAgent() {
 	if (nodePositions.size() == 0)
 		return;
 
-	if (currentNodeIndex < 0) currentNodeIndex = 0;
-	if (currentNodeIndex >= nodePositions.size()) currentNodeIndex = 0;
-	Vector2 target = nodePositions[currentNodeIndex];
-
-	if (Vector2Length(agent->position - target) > 10) agent->updateFrame(obj);
+	if (Vector2Length(agent->position - obj->position) > 10) agent->updateFrame(obj);
 	else {
-		// Increment, then check if it's time to reset, and only after update obj position
-		currentNodeIndex++;
-		if (currentNodeIndex >= nodePositions.size()) {
-			currentNodeIndex = 0;
-			nodePositions.clear();
-			return;
-		}
-		obj->position = nodePositions[currentNodeIndex];
+		// updateFrame is what draws it, so it still has to be drawn while it waits on the node (Like the pause at the end of a path)
+		agent->drawAgent();
+		arrived.fire();
 	}
 }
 
@@ -79,40 +94,133 @@ void PathfollowAgent::debugDraw() {
 	}
 }
 
-SeparatedAgents::SeparatedAgents() : numOfAgents(0), trackedObject(nullptr) {}
+SeparatedAgents::SeparatedAgents() : agentPool(nullptr), numOfAgents(0), trackedObject(nullptr), perceivedObject(nullptr) {}
 
 SeparatedAgents::SeparatedAgents(int _numOfAgents) {
-	trackedObject = new Player(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 3 }, 25.0f, 5.0f);
-
-	numOfAgents = _numOfAgents;
-	for (int i = 0; i < numOfAgents; i++) {
+	agentPool = arena.create<Pool<Agent>>(arena, maxAgents);
+	agentList.reserve(maxAgents);
+	targetHandles.reserve(maxAgents);
+	resolvedTargetIndices.reserve(maxAgents);
+	resolvedTargets.reserve(maxAgents);
+	flock.reserve(maxAgents);
+	predictor.reserve(maxAgents);
+	// Every agent plus the player
+	perception.reserve(maxAgents, maxAgents + 1);
+	trackedObject = arena.create<Player>(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 3 }, 25.0f, 5.0f);
+	perceivedObject = arena.create<Object>(trackedObject->position, 0.0f, 0.0f);
+
+	numOfAgents = 0;
+	for (int i = 0; i < _numOfAgents; i++) {
 		// Ugly but needed way to spawn agents a bit randomly 
 		// (If they spawn inside of each other then they'll stay like that)
-		Agent* agent;
-		agent = new Agent(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 2 + (agentRadius * (i + 1)) },
-			agentRadius, 3.0f, 0, 0.1f, true);
-
 		// Set agent behavior (Can vary per agent) (Default behavior is seek but we explicitly define it here)
-		agentList.push_back(agent);
+		spawnAgent(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 2 + (agentRadius * (i + 1)) });
 	}
 }
 
 void SeparatedAgents::update() {
+	handleSpawnInput();
+	if (IsKeyPressed(KEY_F))
+		flocking = !flocking;
+	if (flocking) {
+		updateFlocking();
+		return;
+	}
+	if (IsKeyPressed(KEY_V))
+		viewCones = !viewCones;
+	if (viewCones) {
+		updateViewCones();
+		return;
+	}
+
+	if (IsKeyPressed(KEY_C))
+		predictiveAvoidance = !predictiveAvoidance;
+	if (predictiveAvoidance)
+		predictor.apply(agentList, getMinDistance(agentRadius, agentRadius) / (2.0f * agentRadius));
+	else
+		predictor.avoidedThisFrame = 0;
 	handleCollision();
+	DrawText(TextFormat("Predictive avoidance (C to toggle): %s, %d avoiding, %d overlaps pushed apart",
+		predictiveAvoidance ? "on" : "off", predictor.avoidedThisFrame, overlapsCorrected), 10, GetScreenHeight() - 105, 20, RED);
 	if (trackedObject) {
 		trackedObject->Update();
 	}
-	for (Agent* a : agentList) {
-		a->updateFrame(trackedObject);
+	resolveTargets();
+	for (int i = 0; i < agentList.size(); i++) {
+		agentList[i]->updateFrame(trackedObject, resolvedTargets[i]);
 	}
 	trackedObject->Update();
 }
 
+// Boids replace both the collision pushing and the agents' own behaviors while it's on
+void SeparatedAgents::updateFlocking() {
+	trackedObject->Update();
+	flock.update(agentList, trackedObject);
+	for (int i = 0; i < agentList.size(); i++) {
+		agentList[i]->drawAgent();
+		agentList[i]->OutOfBoundsChecker();
+	}
+	flock.drawStats(10, GetScreenHeight() - 135);
+}
+
+// Everyone sees everyone else and the player, all cones are answered in one perception pass before anyone moves
+void SeparatedAgents::updateViewCones() {
+	static ObstacleAndPlayerAvoidanceBehavior coneBehavior;
+	trackedObject->Update();
+
+	perception.clearObjects();
+	for (Agent* agent : agentList)
+		perception.addObject(agent->position);
+	perception.addObject(trackedObject->position);
+	perception.perceive(agentList, true);
+
+	for (int i = 0; i < agentList.size(); i++) {
+		Agent& agent = *agentList[i];
+		Object* toAvoid = nullptr;
+		if (perception.counts[i] > 0) {
+			perceivedObject->position = perception.centroids[i];
+			toAvoid = perceivedObject;
+		}
+		coneBehavior.execute(agent, toAvoid);
+
+		if (agent.drawDebugLines) {
+			Color coneColor = toAvoid ? ORANGE : LIGHTGRAY;
+			DrawLineV(agent.position, agent.position + Vector2Rotate(agent.forwardDirection, perception.halfAngle) * perception.range, coneColor);
+			DrawLineV(agent.position, agent.position + Vector2Rotate(agent.forwardDirection, -perception.halfAngle) * perception.range, coneColor);
+		}
+		agent.drawAgent();
+		agent.OutOfBoundsChecker();
+	}
+	perception.drawStats(10, GetScreenHeight() - 135);
+}
+
+// Turns every agent's target handle into an Object* with one pass over the handle table,
+// Instead of each agent looking its own handle up
+void SeparatedAgents::resolveTargets() {
+	int count = agentList.size();
+	targetHandles.resize(count);
+	resolvedTargetIndices.resize(count);
+	resolvedTargets.resize(count);
+
+	for (int i = 0; i < count; i++)
+		targetHandles[i] = agentList[i]->playerTarget;
+
+	HandleTable<Object*>& table = objectTable();
+	table.resolveAll(targetHandles.data(), resolvedTargetIndices.data(), count);
+
+	for (int i = 0; i < count; i++) {
+		uint32_t index = resolvedTargetIndices[i];
+		resolvedTargets[i] = index != HandleTable<Object*>::noDense ? table.dense[index] : nullptr;
+	}
+}
+
 float SeparatedAgents::getMinDistance(int dist1, int dist2) {
 	return (dist1 + dist2) * 2;
 }
 
 void SeparatedAgents::handleCollision() {
+	resolveTargets();
+	overlapsCorrected = 0;
 	for (int i = 0; i < agentList.size(); i++) {
 		for (int j = i + 1; j < agentList.size(); j++) {
 			Vector2 diff = agentList[i]->position - agentList[j]->position;
@@ -127,22 +235,55 @@ void SeparatedAgents::handleCollision() {
 
 				float penetration = (minimumDistance - dist) * 0.5f;
 				agentList[i]->position += normal * penetration;
+				overlapsCorrected++;
 			}
 		}
-		agentList[i]->updateFrame(trackedObject);
+		agentList[i]->updateFrame(trackedObject, resolvedTargets[i]);
 	}
 }
 
-SeparatedAgents::~SeparatedAgents() {
-	for (int i = 0; i < agentList.size(); i++) {
-		delete agentList[i];
+// O(1), the agent comes off the pool's free list and agentList has its capacity reserved
+Agent* SeparatedAgents::spawnAgent(Vector2 position) {
+	Agent* agent = agentPool->spawn(position, agentRadius, 3.0f, 0, 0.1f, true);
+	if (!agent)
+		return nullptr;
+	agentList.push_back(agent);
+	numOfAgents = agentList.size();
+	flock.lists.invalidate();
+	return agent;
+}
+
+// Also O(1), order of agentList doesn't matter so we swap the last one into the hole
+void SeparatedAgents::despawnAgent(int index) {
+	if (index < 0 || index >= agentList.size())
+		return;
+	agentPool->despawn(agentList[index]);
+	agentList[index] = agentList.back();
+	agentList.pop_back();
+	numOfAgents = agentList.size();
+	flock.lists.invalidate();
+}
+
+void SeparatedAgents::handleSpawnInput() {
+	if (IsKeyPressed(KEY_EQUAL)) {
+		Vector2 position = { (float)GetRandomValue(0, GetScreenWidth()), (float)GetRandomValue(0, GetScreenHeight()) };
+		spawnAgent(position);
 	}
-	delete trackedObject;
+	if (IsKeyPressed(KEY_MINUS) && numOfAgents > 0)
+		despawnAgent(GetRandomValue(0, numOfAgents - 1));
+
+	DrawText(TextFormat("Agents: %d/%d (+/- to spawn/despawn)", numOfAgents, maxAgents), 10, GetScreenHeight() - 80, 20, RED);
+}
+
+// The pool, agents and player all live in the arena
+SeparatedAgents::~SeparatedAgents() {
+	agentList.clear();
+	arena.reset();
 }
 
 
 ObjectAvoidance::ObjectAvoidance(int numAgents) : SeparatedAgents(numAgents) {
-	dummyObject = new Object(trackedObject->position, trackedObject->radius, 0);
+	dummyObject = arena.create<Object>(trackedObject->position, trackedObject->radius, 0);
 	// Walls
 	walls.push_back(LineWall({ 150, 150 }, { 300, 150 }));
 	walls.push_back(LineWall({ 500, 400 }, { 500, 550 }));
@@ -153,14 +294,22 @@ ObjectAvoidance::ObjectAvoidance(int numAgents) : SeparatedAgents(numAgents) {
 	walls.push_back(LineWall({ 1000, 200 }, { 1000, 350 }));
 	walls.push_back(LineWall({ 1000, 350 }, { 800, 350 }));
 	walls.push_back(LineWall({ 800, 350 }, { 800, 200 }));
+
+	lineOfSight.reserve(maxAgents);
+	lineOfSight.setWalls(walls);
+	playerVisible.reserve(maxAgents);
 }
 
+// dummyObject is released with the rest of the arena in ~SeparatedAgents
 ObjectAvoidance::~ObjectAvoidance() {
-	delete dummyObject;
 }
 
 void ObjectAvoidance::update() {
 	avoidWalls();
+	if (IsKeyPressed(KEY_L))
+		lineOfSightEnabled = !lineOfSightEnabled;
+	if (lineOfSightEnabled)
+		applyLineOfSight();
 
 	SeparatedAgents::update();
 
@@ -209,10 +358,41 @@ void ObjectAvoidance::avoidWalls() {
 		if (raycastHit) {
 			// change target position
 			dummyObject->position = _a->position + avoidDir * rayLength;
-			_a->playerTarget = dummyObject;
+			_a->playerTarget = dummyObject->handle;
 		}
 		else
-			_a->playerTarget = trackedObject;
+			_a->playerTarget = trackedObject->handle;
+	}
+}
+
+// All agents ask at once, most of the answers come out of the cache while the agents and the player stand still
+void ObjectAvoidance::applyLineOfSight() {
+	for (Agent* agent : agentList)
+		lineOfSight.request(agent->id, trackedObject->handle.index, agent->position, trackedObject->position);
+	lineOfSight.resolve();
+
+	playerVisible.resize(agentList.size());
+	for (int i = 0; i < agentList.size(); i++) {
+		Agent* agent = agentList[i];
+		bool visible = lineOfSight.visible(i);
+		playerVisible[i] = visible;
+		if (agent->drawDebugLines)
+			DrawLineV(agent->position, trackedObject->position, visible ? Fade(GREEN, 0.3f) : Fade(RED, 0.3f));
+	}
+	lineOfSight.drawStats(10, GetScreenHeight() - 160);
+}
+
+// updateFrame points every agent back at the player after each pass, so hiding it has to happen on every resolve
+// Rather than once on playerTarget. Wall avoidance redirecting it to the dummy still goes ahead
+void ObjectAvoidance::resolveTargets() {
+	SeparatedAgents::resolveTargets();
+	if (!lineOfSightEnabled)
+		return;
+	// Agents spawned after applyLineOfSight this frame haven't been checked yet, they count as seeing it
+	int checked = playerVisible.size() < agentList.size() ? playerVisible.size() : agentList.size();
+	for (int i = 0; i < checked; i++) {
+		if (!playerVisible[i] && resolvedTargets[i] == trackedObject)
+			resolvedTargets[i] = nullptr;
 	}
 }
 
@@ -258,22 +438,32 @@ void Pad::drawPad(Color _color) {
 }
 
 JumpingAgent::JumpingAgent() {
-	agent = new Agent(Vector2{ (float)GetScreenWidth() / 6, (float)GetScreenHeight() / 4 }, 25.0f, 5.0f, 0, 0.1f, true);
-	player = new Player(Vector2{ (float)GetScreenWidth() / 1.2f, (float)GetScreenHeight() / 2 }, 25.0f, 8.0f);
-	pad = new Pad(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 5 }, Vector2{ 50, 150 });
-	deathPad = new Pad(Vector2{ (float)GetScreenWidth() / 1.85f, (float)GetScreenHeight() / 6 }, Vector2{ 100, 450 });
+	agent = arena.create<Agent>(Vector2{ (float)GetScreenWidth() / 6, (float)GetScreenHeight() / 4 }, 25.0f, 5.0f, 0, 0.1f, true);
+	player = arena.create<Player>(Vector2{ (float)GetScreenWidth() / 1.2f, (float)GetScreenHeight() / 2 }, 25.0f, 8.0f);
+	pad = arena.create<Pad>(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 5 }, Vector2{ 50, 150 });
+	deathPad = arena.create<Pad>(Vector2{ (float)GetScreenWidth() / 1.85f, (float)GetScreenHeight() / 6 }, Vector2{ 100, 450 });
 	hasJumped = false;
 	jumpAcceleration = { 0, 0 };
 	gravity = 0.4f;
 	zPosition = 0.0f;
 	jumpSpeed = 0;
 	baseRadius = agent->radius;
+	script = jumpSequence();
+	script.start();
 }
 
+// Previously deathPad was never deleted, now the arena releases all four together (And the script's frame)
 JumpingAgent::~JumpingAgent() {
-	delete agent;
-	delete player;
-	delete pad;
+	script.stop();
+	arena.reset();
+}
+
+AgentScript JumpingAgent::jumpSequence() {
+	while (true) {
+		co_await reachedPad;
+		jump();
+		co_await landed;
+	}
 }
 
 void JumpingAgent::jump() {
@@ -297,6 +487,7 @@ void JumpingAgent::applyJumpPhysics() {
 			jumpSpeed = 0.0f;
 			hasJumped = false;
 			agent->radius = baseRadius;
+			landed.fire();
 		}
 		else {
 			float scale = 1.0f + (zPosition * 0.008f);
@@ -307,7 +498,7 @@ void JumpingAgent::applyJumpPhysics() {
 
 void JumpingAgent::checkPads() {
 	if (!hasJumped && zPosition <= 0.0f && pad->isAgentOnThisPad(agent, baseRadius)) {
-		jump();
+		reachedPad.fire();
 	}
 	if (deathPad->isAgentOnThisPad(agent, baseRadius) && zPosition <= 0.0f)
 		respawn();
@@ -327,19 +518,17 @@ void JumpingAgent::update() {
 }
 
 ComposedAgents::ComposedAgents() {
+	TRACK_ALLOCATIONS("ComposedAgents::ComposedAgents");
 	currentBehavior = Pathfollow;
 
-	pathFollowBehavior = new PathfollowAgent(5);
-	separatedAgentsBehavior = new SeparatedAgents(5);
-	collisionAvoidanceBehavior = new ObjectAvoidance(5);
-	jumpingBehavior = new JumpingAgent();
+	pathFollowBehavior = arena.create<PathfollowAgent>(5);
+	separatedAgentsBehavior = arena.create<SeparatedAgents>(5);
+	collisionAvoidanceBehavior = arena.create<ObjectAvoidance>(5);
+	jumpingBehavior = arena.create<JumpingAgent>();
 }
 
 ComposedAgents::~ComposedAgents() {
-	delete pathFollowBehavior;
-	delete separatedAgentsBehavior;
-	delete collisionAvoidanceBehavior;
-	delete jumpingBehavior;
+	arena.reset();
 }
 
 void ComposedAgents::displayDebug() {
@@ -367,8 +556,12 @@ void ComposedAgents::displayDebug() {
 }
 
 void ComposedAgents::browseStates() {
+	AgentBehaviors previous = currentBehavior;
 	if (IsKeyPressed(KEY_ONE)) currentBehavior = Pathfollow;
 	if (IsKeyPressed(KEY_TWO)) currentBehavior = AgentSeparation;
 	if (IsKeyPressed(KEY_THREE)) currentBehavior = CollisionAvoidance;
 	if (IsKeyPressed(KEY_FOUR)) currentBehavior = AgentJumping;
+
+	if (currentBehavior != previous)
+		AllocationTracker::markTransition();
 }
\ No newline at end of file
@@ -5,6 +5,12 @@
 #include "resource_dir.h"
 
 #include "Agent.h"
+#include "AgentScript.h"
+#include "Arena.h"
+#include "CollisionPrediction.h"
+#include "Flocking.h"
+#include "LineOfSight.h"
+#include "Perception.h"
 #include "memory.h"
 #include <vector>
 
@@ -20,20 +26,33 @@ enum AgentBehaviors {
 	AgentJumping,
 };
 
+// Every scenario below owns a ScenarioArena (see Arena.h) that everything it spawns lives in,
+// So the destructors don't delete anything themselves, the arena resets in one go.
+// The node to node logic is a coroutine (followPaths, see AgentScript.h), update() only moves the agent
+// And tells the script when it has arrived
 struct PathfollowAgent {
+	ScenarioArena arena;
 	std::vector<Vector2> nodePositions;
 	Agent* agent;
 	Object* obj;
 	int currentNodeIndex = 0;
 	int maximumPathCount = 5;
+	// Counter for the random node positions, one step per path
+	uint32_t pathsGenerated = 0;
 	float width;
 	float height;
+	// How long the agent waits at the end of a path before it gets a new one
+	static constexpr uint32_t pauseTicks = 30;
+	ScriptScheduler scripts;
+	ScriptEvent arrived;
+	AgentScript script;
 
 	PathfollowAgent(int _maximumPathCount);
 	~PathfollowAgent();
 	void update();
 	void generateNewPath();
 	void updatePathFollowAgent();
+	AgentScript followPaths();
 	void debugDraw();
 };
 
@@ -41,10 +60,31 @@ struct PathfollowAgent {
 // I implemented collision separately since a ghost might not have any collision
 // So it made sense to have collision implemented separately
 struct SeparatedAgents {
+	ScenarioArena arena;
+	// Agents come from a fixed size pool so spawning/despawning at runtime never hits malloc.
+	// They aren't in objectTable(), so the pool isn't compacted and agentList is what holds on to them
+	Pool<Agent>* agentPool;
 	std::vector<Agent*> agentList;
 	int numOfAgents;
 	const float agentRadius = 25.0f;
+	static constexpr int maxAgents = 64;
 	Player* trackedObject;
+	// Scratch space for resolving all agent targets at once, reserved to maxAgents
+	std::vector<EntityHandle> targetHandles;
+	std::vector<uint32_t> resolvedTargetIndices;
+	std::vector<Object*> resolvedTargets;
+	// F switches the crowd between separation and boids flocking
+	bool flocking = false;
+	Flock flock;
+	// C toggles looking ahead for collisions, overlapsCorrected is how many pushes handleCollision still had to do
+	bool predictiveAvoidance = true;
+	CollisionPredictor predictor;
+	int overlapsCorrected = 0;
+	// V has the agents wander and flee from whatever is in their view cone instead (ObstacleAndPlayerAvoidanceBehavior)
+	bool viewCones = false;
+	ConePerception perception;
+	// Stands in for the cone's centroid when it's handed to the behavior
+	Object* perceivedObject;
 
 	SeparatedAgents();
 	SeparatedAgents(int _numOfAgents);
@@ -52,6 +92,13 @@ struct SeparatedAgents {
 	virtual void update();
 	virtual float getMinDistance(int dist1, int dist2);
 	void handleCollision();
+	// Fills resolvedTargets, both behavior passes in update() go through it
+	virtual void resolveTargets();
+	Agent* spawnAgent(Vector2 position);
+	void despawnAgent(int index);
+	void handleSpawnInput();
+	void updateFlocking();
+	void updateViewCones();
 	virtual ~SeparatedAgents();
 };
 
@@ -69,6 +116,11 @@ struct LineWall {
 struct ObjectAvoidance : SeparatedAgents {
 	std::vector<LineWall> walls;
 	Object* dummyObject;
+	// L makes agents only go for the player while they can see it, the rest wait until it comes into view
+	bool lineOfSightEnabled = false;
+	LineOfSight lineOfSight;
+	// Per agent in agentList order, from this frame's applyLineOfSight
+	std::vector<uint8_t> playerVisible;
 
 	const int wallCount = 3;
 
@@ -77,6 +129,8 @@ struct ObjectAvoidance : SeparatedAgents {
 	void update() override;
 	float getMinDistance(int dist1, int dist2) override;
 	void avoidWalls();
+	void applyLineOfSight();
+	void resolveTargets() override;
 	void drawWalls();
 };
 
@@ -94,6 +148,7 @@ struct Pad {
 // And check if the agent is on the jumping pad, then it will jump. Naturally this would probably be hidden.
 // Potentially it would make more sense to temporarily change the direction of the agent towards the jumping pad
 // But I wasn't sure if I should do that (It's quite easy to do and would just make it harder to test if the agent doesn't jump)
+// The approach, jump, land sequence is a coroutine (jumpSequence, see AgentScript.h) waiting on the pad and landing events
 struct JumpingAgent {
 	Agent* agent;
 	Player* player;
@@ -106,9 +161,15 @@ struct JumpingAgent {
 	float gravity;
 	float baseRadius;
 
+	ScenarioArena arena;
+	ScriptEvent reachedPad;
+	ScriptEvent landed;
+	AgentScript script;
+
 	JumpingAgent();
 	~JumpingAgent();
 
+	AgentScript jumpSequence();
 	void jump();
 	void respawn();
 	void applyJumpPhysics();
@@ -119,6 +180,8 @@ struct JumpingAgent {
 
 // This is the struct that manages the above composed agents
 struct ComposedAgents {
+	// Holds the four scenarios themselves, each of which then has its own arena
+	ScenarioArena arena;
 	AgentBehaviors currentBehavior;
 
 	PathfollowAgent* pathFollowBehavior;
@@ -0,0 +1,122 @@
+#include "Ecs.h"
+
+void Archetype::reserve(int count) {
+	entities.reserve(count);
+	forEachColumn([this, count](uint32_t bit, auto& column) {
+		if (mask & bit) column.reserve(count);
+	});
+}
+
+int Archetype::pushRow(EntityHandle entity) {
+	entities.push_back(entity);
+	forEachColumn([this](uint32_t bit, auto& column) {
+		using Component = typename std::decay_t<decltype(column)>::value_type;
+		if (mask & bit) column.push_back(Component());
+	});
+	return size() - 1;
+}
+
+template<typename T>
+static void swapRemove(std::vector<T>& column, int row) {
+	column[row] = column.back();
+	column.pop_back();
+}
+
+EntityHandle Archetype::removeRow(int row) {
+	int last = size() - 1;
+	EntityHandle moved = row != last ? entities[last] : EntityHandle::invalid();
+
+	swapRemove(entities, row);
+	forEachColumn([this, row](uint32_t bit, auto& column) {
+		if (mask & bit) swapRemove(column, row);
+	});
+	return moved;
+}
+
+void Archetype::copySharedRow(int row, const Archetype& from, int fromRow) {
+	uint32_t shared = mask & from.mask;
+	Archetype& source = const_cast<Archetype&>(from);
+	forEachColumn([shared, row, &source, fromRow](uint32_t bit, auto& column) {
+		using Component = typename std::decay_t<decltype(column)>::value_type;
+		if (shared & bit) column[row] = ComponentTraits<Component>::column(source)[fromRow];
+	});
+}
+
+int World::findOrCreateArchetype(uint32_t mask) {
+	for (int i = 0; i < archetypes.size(); i++) {
+		if (archetypes[i].mask == mask)
+			return i;
+	}
+	archetypes.push_back(Archetype(mask));
+	return (int)archetypes.size() - 1;
+}
+
+EntityHandle World::createEntity(uint32_t mask) {
+	int archetypeIndex = findOrCreateArchetype(mask);
+	EntityHandle entity = locations.insert(EntityLocation{ archetypeIndex, 0 });
+	int row = archetypes[archetypeIndex].pushRow(entity);
+	locations.get(entity)->row = row;
+	return entity;
+}
+
+void World::destroyEntity(EntityHandle entity) {
+	EntityLocation* location = locations.get(entity);
+	if (!location)
+		return;
+
+	EntityHandle moved = archetypes[location->archetype].removeRow(location->row);
+	if (!moved.isNull())
+		locations.get(moved)->row = location->row;
+	locations.remove(entity);
+}
+
+void World::setComponents(EntityHandle entity, uint32_t mask) {
+	EntityLocation* location = locations.get(entity);
+	if (!location || archetypes[location->archetype].mask == mask)
+		return;
+
+	int oldArchetype = location->archetype;
+	int oldRow = location->row;
+	// findOrCreateArchetype can grow the archetype vector, so no references across it
+	int newArchetype = findOrCreateArchetype(mask);
+	int newRow = archetypes[newArchetype].pushRow(entity);
+	archetypes[newArchetype].copySharedRow(newRow, archetypes[oldArchetype], oldRow);
+
+	EntityHandle moved = archetypes[oldArchetype].removeRow(oldRow);
+	if (!moved.isNull())
+		locations.get(moved)->row = oldRow;
+
+	location = locations.get(entity);
+	location->archetype = newArchetype;
+	location->row = newRow;
+}
+
+bool World::isAlive(EntityHandle entity) const {
+	return locations.valid(entity);
+}
+
+void World::reserve(uint32_t mask, int count) {
+	archetypes.reserve(archetypes.size() + 1);
+	archetypes[findOrCreateArchetype(mask)].reserve(count);
+	locations.reserve(locations.size() + count);
+}
+
+void World::clear() {
+	// Remove one by one instead of replacing the table so generations keep counting up,
+	// That way handles from before the clear are still detected as stale
+	while (locations.size() > 0)
+		locations.remove(locations.handleAt(0));
+	archetypes.clear();
+	walls.clear();
+	pads.clear();
+	wakeEvents.clear();
+	timers.clear();
+	influence.clear();
+	for (TimeSlice& slice : aiSlices)
+		slice.clear();
+	tick = 0;
+}
+
+int World::entityCount() const {
+	return locations.size();
+}
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "Agent.h"
+#include "BehaviorTree.h"
+#include "HandleTable.h"
+#include "InfluenceMap.h"
+#include "TimeSlicer.h"
+#include "TimingWheel.h"
+
+// Entity component system used by part 3.
+// Instead of a class per combination (SeparatedAgents -> ObjectAvoidance etc.) an entity is just a handle,
+// And what it does is decided by which components it has. Entities with the same set of components
+// Share an archetype, which keeps every component in its own dense column (one std::vector per component)
+// So systems walk plain arrays instead of chasing Agent pointers.
+
+// Components
+struct Position {
+	Vector2 value = { 0, 0 };
+};
+
+struct Velocity {
+	Vector2 value = { 0, 0 };
+};
+
+struct Orientation {
+	float angle = 0.0f;
+	Vector2 forward = { 1, 0 };
+	float rotationSmoothness = 0.2f;
+};
+
+// What the agent is steering towards this frame and how.
+// targetPosition/targetVelocity are filled from the target entity each frame,
+// Systems like path following or wall avoidance may then override them (Like dummyObject did)
+struct Steering {
+	Behaviors behavior = Seek;
+	float speed = 3.0f;
+	float maxAcceleration = 0.2f;
+	EntityHandle target = EntityHandle::invalid();
+	Vector2 targetPosition = { 0, 0 };
+	Vector2 targetVelocity = { 0, 0 };
+	bool hasTarget = false;
+	AgentBehaviorState state;
+};
+
+struct JumpState {
+	float zPosition = 0.0f;
+	float jumpSpeed = 0.0f;
+	float gravity = 0.4f;
+	bool hasJumped = false;
+	Vector2 spawnPoint = { 0, 0 };
+};
+
+// Fixed size so regenerating a path never allocates
+struct Path {
+	static constexpr int maxNodes = 8;
+	Vector2 nodes[maxNodes];
+	int nodeCount = 0;
+	int currentNode = 0;
+	int maximumPathCount = 5;
+};
+
+// separationScale replaces the getMinDistance override, (r1 + r2) * scale
+struct Collider {
+	float radius = 25.0f;
+	float baseRadius = 25.0f;
+	float separationScale = 2.0f;
+};
+
+// Tag for the WASD controlled entity
+struct PlayerInput {
+	float speed = 5.0f;
+};
+
+// Used by the blended pipeline (SteeringPipeline.h): behaviors add weighted requests here
+// Instead of moving the agent themselves, and one integrator applies the sum.
+struct Acceleration {
+	Vector2 linear = { 0, 0 };
+	// Radians to turn this tick, integrated into Orientation
+	float angular = 0.0f;
+	// Priority composition only: set once a priority level produced a request, lower levels skip the agent
+	bool resolved = false;
+};
+
+struct SteeringWeights {
+	float target = 1.0f;
+	float separation = 2.0f;
+	float walls = 3.0f;
+};
+
+// ORCA local planner settings (Orca.h). Time horizons are in frames since velocities are per frame
+struct Avoidance {
+	float neighbourDistance = 120.0f;
+	int maxNeighbours = 10;
+	float timeHorizon = 40.0f;
+	float wallTimeHorizon = 15.0f;
+};
+
+// Something evaders run from (ThreatEvasion.h), weight scales how much it counts
+struct Threat {
+	float weight = 1.0f;
+};
+
+// Flee from every threat within radius instead of one target, only the closest maxThreats count
+struct Evasion {
+	float radius = 300.0f;
+	int maxThreats = 8;
+	// How many threats were considered last frame, for the overlay
+	int threatCount = 0;
+};
+
+// Stamps a kernel into the world's influence map (InfluenceMap.h), remembers where so it can take it back out when it moves
+struct InfluenceSource {
+	InfluenceLayer layer = DangerLayer;
+	float strength = 1.0f;
+	int stampedCell = -1;
+	float stampedStrength = 0.0f;
+};
+
+// Picks seek or flee from the influence map instead of from a target
+struct InfluenceSensing {
+	// How far ahead along the gradient the steering target goes
+	float lookahead = 100.0f;
+	// Danger has to beat opportunity times this to make it flee
+	float courage = 1.0f;
+};
+
+// Lets a behavior tree (BehaviorTree.h) pick Steering::behavior every tick
+struct BehaviorTreeAgent {
+	BehaviorTreeId tree = ScoutTree;
+	Blackboard blackboard;
+};
+
+// Behavior picked by the utility scorer (UtilityAI.h) every interval ticks instead of every tick,
+// Timed by World::timers (See startUtilityTimer)
+struct UtilityAgent {
+	uint16_t interval = 10;
+};
+
+// Update rate of an agent's steering (AiLod.h). phase staggers agents on the same level
+struct AiLod {
+	uint8_t level = 0;
+	uint8_t phase = 0;
+	bool due = true;
+	// Ticks since steering last ran for it, the next update makes up for them
+	uint8_t ticksSkipped = 0;
+};
+
+// Settled agents go to sleep and are left out of the behavior, steering and separation passes (Sleep.h).
+// target and targetPosition are what the agent had when it fell asleep, so a change can wake it
+struct Sleep {
+	bool asleep = false;
+	bool hadTarget = false;
+	uint16_t quietTicks = 0;
+	EntityHandle target = EntityHandle::invalid();
+	Vector2 targetPosition = { 0, 0 };
+};
+
+enum ComponentBit : uint32_t {
+	PositionBit = 1 << 0,
+	VelocityBit = 1 << 1,
+	OrientationBit = 1 << 2,
+	SteeringBit = 1 << 3,
+	JumpBit = 1 << 4,
+	PathBit = 1 << 5,
+	ColliderBit = 1 << 6,
+	PlayerInputBit = 1 << 7,
+	AccelerationBit = 1 << 8,
+	SteeringWeightsBit = 1 << 9,
+	AvoidanceBit = 1 << 10,
+	ThreatBit = 1 << 11,
+	EvasionBit = 1 << 12,
+	InfluenceSourceBit = 1 << 13,
+	InfluenceSensingBit = 1 << 14,
+	BehaviorTreeBit = 1 << 15,
+	UtilityBit = 1 << 16,
+	AiLodBit = 1 << 17,
+	SleepBit = 1 << 18,
+};
+
+// One archetype per unique component mask.
+// Every archetype has a column for every component type, but only the ones in its mask are filled.
+struct Archetype {
+	uint32_t mask;
+	std::vector<EntityHandle> entities;
+
+	std::vector<Position> positions;
+	std::vector<Velocity> velocities;
+	std::vector<Orientation> orientations;
+	std::vector<Steering> steerings;
+	std::vector<JumpState> jumps;
+	std::vector<Path> paths;
+	std::vector<Collider> colliders;
+	std::vector<PlayerInput> playerInputs;
+	std::vector<Acceleration> accelerations;
+	std::vector<SteeringWeights> steeringWeights;
+	std::vector<Avoidance> avoidances;
+	std::vector<Threat> threats;
+	std::vector<Evasion> evasions;
+	std::vector<InfluenceSource> influenceSources;
+	std::vector<InfluenceSensing> influenceSensings;
+	std::vector<BehaviorTreeAgent> behaviorTrees;
+	std::vector<UtilityAgent> utilities;
+	std::vector<AiLod> aiLods;
+	std::vector<Sleep> sleeps;
+
+	Archetype(uint32_t _mask) : mask(_mask) {}
+
+	// Calls f(bit, column) for every component column, so the row operations below can't miss one
+	template<typename F>
+	void forEachColumn(F f) {
+		f(PositionBit, positions);
+		f(VelocityBit, velocities);
+		f(OrientationBit, orientations);
+		f(SteeringBit, steerings);
+		f(JumpBit, jumps);
+		f(PathBit, paths);
+		f(ColliderBit, colliders);
+		f(PlayerInputBit, playerInputs);
+		f(AccelerationBit, accelerations);
+		f(SteeringWeightsBit, steeringWeights);
+		f(AvoidanceBit, avoidances);
+		f(ThreatBit, threats);
+		f(EvasionBit, evasions);
+		f(InfluenceSourceBit, influenceSources);
+		f(InfluenceSensingBit, influenceSensings);
+		f(BehaviorTreeBit, behaviorTrees);
+		f(UtilityBit, utilities);
+		f(AiLodBit, aiLods);
+		f(SleepBit, sleeps);
+	}
+
+	int size() const {
+		return (int)entities.size();
+	}
+
+	bool has(uint32_t required) const {
+		return (mask & required) == required;
+	}
+
+	void reserve(int count);
+	// Appends a row of default components, returns the row
+	int pushRow(EntityHandle entity);
+	// Swap removes a row, returns the handle of the entity that moved into it (or invalid)
+	EntityHandle removeRow(int row);
+	// Copies the components both archetypes share from a row of another archetype
+	void copySharedRow(int row, const Archetype& from, int fromRow);
+};
+
+// Maps a component type to its bit and column
+template<typename T> struct ComponentTraits;
+template<> struct ComponentTraits<Position> { static constexpr uint32_t bit = PositionBit; static std::vector<Position>& column(Archetype& a) { return a.positions; } };
+template<> struct ComponentTraits<Velocity> { static constexpr uint32_t bit = VelocityBit; static std::vector<Velocity>& column(Archetype& a) { return a.velocities; } };
+template<> struct ComponentTraits<Orientation> { static constexpr uint32_t bit = OrientationBit; static std::vector<Orientation>& column(Archetype& a) { return a.orientations; } };
+template<> struct ComponentTraits<Steering> { static constexpr uint32_t bit = SteeringBit; static std::vector<Steering>& column(Archetype& a) { return a.steerings; } };
+template<> struct ComponentTraits<JumpState> { static constexpr uint32_t bit = JumpBit; static std::vector<JumpState>& column(Archetype& a) { return a.jumps; } };
+template<> struct ComponentTraits<Path> { static constexpr uint32_t bit = PathBit; static std::vector<Path>& column(Archetype& a) { return a.paths; } };
+template<> struct ComponentTraits<Collider> { static constexpr uint32_t bit = ColliderBit; static std::vector<Collider>& column(Archetype& a) { return a.colliders; } };
+template<> struct ComponentTraits<PlayerInput> { static constexpr uint32_t bit = PlayerInputBit; static std::vector<PlayerInput>& column(Archetype& a) { return a.playerInputs; } };
+template<> struct ComponentTraits<Acceleration> { static constexpr uint32_t bit = AccelerationBit; static std::vector<Acceleration>& column(Archetype& a) { return a.accelerations; } };
+template<> struct ComponentTraits<SteeringWeights> { static constexpr uint32_t bit = SteeringWeightsBit; static std::vector<SteeringWeights>& column(Archetype& a) { return a.steeringWeights; } };
+template<> struct ComponentTraits<Avoidance> { static constexpr uint32_t bit = AvoidanceBit; static std::vector<Avoidance>& column(Archetype& a) { return a.avoidances; } };
+template<> struct ComponentTraits<Threat> { static constexpr uint32_t bit = ThreatBit; static std::vector<Threat>& column(Archetype& a) { return a.threats; } };
+template<> struct ComponentTraits<Evasion> { static constexpr uint32_t bit = EvasionBit; static std::vector<Evasion>& column(Archetype& a) { return a.evasions; } };
+template<> struct ComponentTraits<InfluenceSource> { static constexpr uint32_t bit = InfluenceSourceBit; static std::vector<InfluenceSource>& column(Archetype& a) { return a.influenceSources; } };
+template<> struct ComponentTraits<InfluenceSensing> { static constexpr uint32_t bit = InfluenceSensingBit; static std::vector<InfluenceSensing>& column(Archetype& a) { return a.influenceSensings; } };
+template<> struct ComponentTraits<BehaviorTreeAgent> { static constexpr uint32_t bit = BehaviorTreeBit; static std::vector<BehaviorTreeAgent>& column(Archetype& a) { return a.behaviorTrees; } };
+template<> struct ComponentTraits<UtilityAgent> { static constexpr uint32_t bit = UtilityBit; static std::vector<UtilityAgent>& column(Archetype& a) { return a.utilities; } };
+template<> struct ComponentTraits<AiLod> { static constexpr uint32_t bit = AiLodBit; static std::vector<AiLod>& column(Archetype& a) { return a.aiLods; } };
+template<> struct ComponentTraits<Sleep> { static constexpr uint32_t bit = SleepBit; static std::vector<Sleep>& column(Archetype& a) { return a.sleeps; } };
+
+struct EntityLocation {
+	int archetype;
+	int row;
+};
+
+// Scene data that isn't per entity, walls and pads are static so they live here
+struct EcsWall {
+	Vector2 start;
+	Vector2 end;
+};
+
+enum PadType {
+	JumpPad,
+	DeathPad,
+};
+
+// Wakes every sleeping agent within radius of position on the next sleep pass (An explosion, a door opening)
+struct WakeEvent {
+	Vector2 position;
+	float radius;
+};
+
+struct EcsPad {
+	Vector2 position;
+	Vector2 size;
+	PadType type;
+};
+
+// How the blended pipeline combines its requests, see SteeringPipeline.h
+enum SteeringComposition {
+	BlendedComposition,
+	PriorityComposition,
+};
+
+// Priority levels in evaluation order
+enum SteeringPriority {
+	WallPriority,
+	SeparationPriority,
+	TargetPriority,
+	SteeringPriorityCount,
+};
+
+// Per frame counters for priority composition
+struct PriorityCounters {
+	int evaluated[SteeringPriorityCount];
+	// How many agents stopped at this level (Everything below it was skipped)
+	int shortCircuited[SteeringPriorityCount];
+	int unresolved;
+};
+
+struct World {
+	std::vector<Archetype> archetypes;
+	HandleTable<EntityLocation> locations;
+	std::vector<EcsWall> walls;
+	std::vector<EcsPad> pads;
+	// Sized by the scenarios that use it, empty otherwise
+	InfluenceMap influence;
+	// Handled and cleared by sleepSystem
+	std::vector<WakeEvent> wakeEvents;
+	// Per agent timers, advanced together with tick after all the systems ran so the callbacks never race a system
+	TimingWheel timers;
+	// Per tick time budgets of the AI systems, no budget unless a scenario sets one
+	TimeSlice aiSlices[AiSubsystemCount];
+	uint32_t tick = 0;
+
+	SteeringComposition steeringComposition = BlendedComposition;
+	PriorityCounters priorityCounters = {};
+
+	EntityHandle createEntity(uint32_t mask);
+	void destroyEntity(EntityHandle entity);
+	// Moves the entity into the archetype for its new mask, keeps the components it already had
+	void setComponents(EntityHandle entity, uint32_t mask);
+	bool isAlive(EntityHandle entity) const;
+	// Reserve room for count entities of a mask up front so spawning during the frame doesn't allocate
+	void reserve(uint32_t mask, int count);
+	void clear();
+	int entityCount() const;
+
+	template<typename T>
+	T* get(EntityHandle entity) {
+		const EntityLocation* location = locations.get(entity);
+		if (!location)
+			return nullptr;
+		Archetype& archetype = archetypes[location->archetype];
+		if (!(archetype.mask & ComponentTraits<T>::bit))
+			return nullptr;
+		return &ComponentTraits<T>::column(archetype)[location->row];
+	}
+
+	// Calls f(archetype) for every archetype that has all of the required components.
+	// Systems then iterate the columns of that archetype directly.
+	template<typename F>
+	void forEachArchetype(uint32_t required, F f) {
+		forEachArchetype(required, 0, f);
+	}
+
+	// Same, but skips archetypes that have any of the excluded components
+	template<typename F>
+	void forEachArchetype(uint32_t required, uint32_t excluded, F f) {
+		for (Archetype& archetype : archetypes) {
+			if (archetype.has(required) && !(archetype.mask & excluded) && archetype.size() > 0)
+				f(archetype);
+		}
+	}
+
+private:
+	int findOrCreateArchetype(uint32_t mask);
+};
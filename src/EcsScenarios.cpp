@@ -0,0 +1,339 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "EcsScenarios.h"
+#include "SteeringPipeline.h"
+#include "Orca.h"
+#include "ThreatEvasion.h"
+#include "InfluenceSystems.h"
+#include "BehaviorTreeSystem.h"
+#include "UtilityAISystem.h"
+#include "UtilityAI.h"
+#include "AiLod.h"
+#include "Sleep.h"
+#include "AllocationTracker.h"
+
+static const uint32_t agentComponents = PositionBit | VelocityBit | OrientationBit | SteeringBit | ColliderBit;
+static const uint32_t playerComponents = PositionBit | VelocityBit | PlayerInputBit | ColliderBit;
+
+EcsScenarios::EcsScenarios() : scheduler(ThreadPool::instance()) {
+	load(EcsPathfollow);
+}
+
+EntityHandle EcsScenarios::spawnPlayer(Vector2 position, float speed) {
+	EntityHandle player = world.createEntity(playerComponents);
+	world.get<Position>(player)->value = position;
+	world.get<PlayerInput>(player)->speed = speed;
+	return player;
+}
+
+EntityHandle EcsScenarios::spawnAgent(uint32_t extraComponents, Vector2 position, float radius, float speed, EntityHandle target) {
+	EntityHandle agent = world.createEntity(agentComponents | extraComponents);
+	world.get<Position>(agent)->value = position;
+	world.get<Collider>(agent)->radius = radius;
+	world.get<Collider>(agent)->baseRadius = radius;
+	world.get<Steering>(agent)->speed = speed;
+	world.get<Steering>(agent)->target = target;
+	if (JumpState* jump = world.get<JumpState>(agent))
+		jump->spawnPoint = position;
+	return agent;
+}
+
+void EcsScenarios::addWalls() {
+	world.walls.push_back(EcsWall{ { 150, 150 }, { 300, 150 } });
+	world.walls.push_back(EcsWall{ { 500, 400 }, { 500, 550 } });
+	world.walls.push_back(EcsWall{ { 400, 700 }, { 550, 750 } });
+
+	world.walls.push_back(EcsWall{ { 800, 200 }, { 1000, 200 } });
+	world.walls.push_back(EcsWall{ { 1000, 200 }, { 1000, 350 } });
+	world.walls.push_back(EcsWall{ { 1000, 350 }, { 800, 350 } });
+	world.walls.push_back(EcsWall{ { 800, 350 }, { 800, 200 } });
+}
+
+void EcsScenarios::addPads() {
+	float width = GetScreenWidth();
+	float height = GetScreenHeight();
+	world.pads.push_back(EcsPad{ { width / 2, height / 5 }, { 50, 150 }, JumpPad });
+	world.pads.push_back(EcsPad{ { width / 1.85f, height / 6 }, { 100, 450 }, DeathPad });
+}
+
+// Each scenario is a set of entities plus the systems that should run over them.
+// The systems only look at component masks, so the mixed scenario reuses all of them as is.
+void EcsScenarios::load(EcsScenarioType scenario) {
+	TRACK_ALLOCATIONS("EcsScenarios::load");
+	AllocationTracker::markTransition();
+
+	currentScenario = scenario;
+	world.clear();
+	systems.systems.clear();
+
+	float width = GetScreenWidth();
+	float height = GetScreenHeight();
+
+	switch (scenario) {
+	case EcsPathfollow: {
+		systems.name = "Pathfollow";
+		systems.systems = {
+			PathFollowPhase,
+			SteeringPhase,
+			BoundsPhase,
+			RenderPhase,
+		};
+		spawnAgent(PathBit, Vector2{ width / 2, height / 6 }, 15.0f, 5.0f, EntityHandle::invalid());
+		break;
+	}
+	case EcsSeparation:
+	case EcsWallAvoidance: {
+		bool walls = scenario == EcsWallAvoidance;
+		systems.name = walls ? "Collision, agent and Wall Avoidance" : "Separated Agents";
+		systems.systems = { PlayerInputPhase, TargetPhase };
+		if (walls)
+			systems.systems.push_back(WallAvoidancePhase);
+		systems.systems.push_back(SeparationPhase);
+		systems.systems.push_back(SteeringPhase);
+		systems.systems.push_back(BoundsPhase);
+		systems.systems.push_back(RenderPhase);
+
+		EntityHandle player = spawnPlayer(Vector2{ width / 2, height / 3 }, 5.0f);
+		for (int i = 0; i < 5; i++) {
+			EntityHandle agent = spawnAgent(0, Vector2{ width / 2, height / 2 + (25.0f * (i + 1)) }, 25.0f, 3.0f, player);
+			// Same as the getMinDistance override, wall avoidance uses a tighter separation
+			world.get<Collider>(agent)->separationScale = walls ? 1.0f : 2.0f;
+		}
+		if (walls)
+			addWalls();
+		break;
+	}
+	case EcsJumping: {
+		systems.name = "Jumping";
+		systems.systems = {
+			PlayerInputPhase,
+			TargetPhase,
+			JumpPhase,
+			SteeringPhase,
+			BoundsPhase,
+			RenderPhase,
+		};
+		EntityHandle player = spawnPlayer(Vector2{ width / 1.2f, height / 2 }, 8.0f);
+		spawnAgent(JumpBit, Vector2{ width / 6, height / 4 }, 25.0f, 5.0f, player);
+		addPads();
+		break;
+	}
+	case EcsMixed: {
+		// Jumping + separation + path following, no new code needed, just components and systems
+		systems.name = "Mixed: Jumping, Separation and Pathfollow";
+		systems.systems = {
+			PathFollowPhase,
+			SeparationPhase,
+			JumpPhase,
+			SteeringPhase,
+			BoundsPhase,
+			RenderPhase,
+		};
+		for (int i = 0; i < 5; i++)
+			spawnAgent(PathBit | JumpBit, Vector2{ width / 6, height / 4 + 60.0f * i }, 20.0f, 4.0f, EntityHandle::invalid());
+		addPads();
+		break;
+	}
+	case EcsBlended: {
+		// The wall avoidance scenario again, but seek, separation and walls are blended with weights
+		// Instead of fighting over the position (See the note in ObjectAvoidance::drawWalls)
+		systems.name = world.steeringComposition == PriorityComposition ? "Priority: Walls > Separation > Seek" : "Blended: Seek + Separation + Walls";
+		systems.systems = { PlayerInputPhase, TargetPhase };
+		addSteeringPasses(systems.systems, world.steeringComposition);
+		systems.systems.push_back(BoundsPhase);
+		systems.systems.push_back(RenderPhase);
+		EntityHandle player = spawnPlayer(Vector2{ width / 2, height / 3 }, 5.0f);
+		for (int i = 0; i < 5; i++) {
+			EntityHandle agent = spawnAgent(AccelerationBit | SteeringWeightsBit, Vector2{ width / 2, height / 2 + (25.0f * (i + 1)) }, 25.0f, 3.0f, player);
+			world.get<Collider>(agent)->separationScale = 1.0f;
+		}
+		addWalls();
+		break;
+	}
+	case EcsCrowd: {
+		// A ring of agents all seeking the player, ORCA keeps them apart without moving anyone after the fact
+		systems.name = "ORCA crowd";
+		systems.systems = { PlayerInputPhase, TargetPhase, OrcaPhase, BoundsPhase, RenderPhase };
+		const int crowdSize = 80;
+		world.reserve(agentComponents | AvoidanceBit, crowdSize);
+		// The crowd and the player
+		reserveOrca(crowdSize + 1);
+		EntityHandle player = spawnPlayer(Vector2{ width / 2, height / 2 }, 5.0f);
+		for (int i = 0; i < crowdSize; i++) {
+			float angle = 2 * PI * i / crowdSize;
+			float distance = 300.0f + 60.0f * (i % 3);
+			spawnAgent(AvoidanceBit, Vector2{ width / 2 + cosf(angle) * distance, height / 2 + sinf(angle) * distance }, 12.0f, 3.0f, player);
+		}
+		addWalls();
+		break;
+	}
+	case EcsThreats: {
+		// Evaders run from every pursuer close by (And the player), pursuers each chase one evader
+		systems.name = "Multi-threat evade";
+		systems.systems = { PlayerInputPhase, TargetPhase, ThreatEvasionPhase, SteeringPhase, SeparationPhase, BoundsPhase, RenderPhase };
+		EntityHandle player = spawnPlayer(Vector2{ width / 2, height / 2 }, 5.0f);
+		world.setComponents(player, playerComponents | ThreatBit);
+
+		const int evaderCount = 6;
+		EntityHandle evaders[evaderCount];
+		for (int i = 0; i < evaderCount; i++) {
+			evaders[i] = spawnAgent(EvasionBit, Vector2{ width / 2 + 150.0f * (i - evaderCount / 2), height / 2 + 100.0f }, 15.0f, 3.5f, EntityHandle::invalid());
+			world.get<Steering>(evaders[i])->behavior = Flee;
+		}
+		const int pursuerCount = 12;
+		// The pursuers and the player
+		reserveThreatEvasion(pursuerCount + 1);
+		for (int i = 0; i < pursuerCount; i++) {
+			float angle = 2 * PI * i / pursuerCount;
+			EntityHandle pursuer = spawnAgent(ThreatBit, Vector2{ width / 2 + cosf(angle) * 450.0f, height / 2 + sinf(angle) * 400.0f }, 20.0f, 2.5f, evaders[i % evaderCount]);
+			world.get<Steering>(pursuer)->behavior = Pursue;
+		}
+		break;
+	}
+	case EcsInfluence: {
+		// The player and a few wandering hunters are danger, the gold pickups are opportunity,
+		// The crowd decides between seek and flee purely from the map
+		systems.name = "Influence map";
+		systems.systems = { PlayerInputPhase, TargetPhase, InfluenceStampPhase, InfluenceSensePhase, SteeringPhase, SeparationPhase, BoundsPhase, InfluenceDrawPhase, RenderPhase };
+		world.influence.resize(width, height, 25.0f, 10);
+
+		EntityHandle player = spawnPlayer(Vector2{ width / 2, height / 2 }, 5.0f);
+		world.setComponents(player, playerComponents | InfluenceSourceBit);
+		world.get<InfluenceSource>(player)->strength = 1.5f;
+
+		Vector2 pickups[4] = { { width / 5, height / 4 }, { width * 4 / 5, height / 4 }, { width / 5, height * 3 / 4 }, { width * 4 / 5, height * 3 / 4 } };
+		for (Vector2 position : pickups) {
+			EntityHandle pickup = world.createEntity(PositionBit | ColliderBit | InfluenceSourceBit);
+			world.get<Position>(pickup)->value = position;
+			world.get<Collider>(pickup)->radius = 10.0f;
+			world.get<Collider>(pickup)->baseRadius = 10.0f;
+			world.get<InfluenceSource>(pickup)->layer = OpportunityLayer;
+		}
+
+		for (int i = 0; i < 3; i++) {
+			EntityHandle hunter = spawnAgent(InfluenceSourceBit, Vector2{ width * (i + 1) / 4, height / 2 }, 20.0f, 2.0f, EntityHandle::invalid());
+			world.get<Steering>(hunter)->behavior = Wander;
+		}
+		for (int i = 0; i < 30; i++) {
+			float angle = 2 * PI * i / 30;
+			spawnAgent(InfluenceSensingBit, Vector2{ width / 2 + cosf(angle) * 300.0f, height / 2 + sinf(angle) * 250.0f }, 10.0f, 3.0f, EntityHandle::invalid());
+		}
+		break;
+	}
+	case EcsBehaviorTrees: {
+		// No keys involved, every agent's tree (Or utility scores) decides between the behaviors based on where the player is
+		systems.name = utilityAI ? "Utility AI" : "Behavior trees";
+		systems.systems = { PlayerInputPhase, TargetPhase, utilityAI ? UtilityAIPhase : BehaviorTreePhase, SteeringPhase, BoundsPhase, RenderPhase };
+		if (aiLod)
+			systems.systems.insert(systems.systems.begin() + 2, AiLodPhase);
+		if (sleeping) {
+			systems.systems.insert(systems.systems.begin() + 2, SleepPhase);
+			// One per player from Space, so pressing it doesn't allocate
+			world.wakeEvents.reserve(4);
+		}
+		EntityHandle player = spawnPlayer(Vector2{ width / 2, height / 2 }, 5.0f);
+		// Wall proximity is one of the utility inputs
+		if (utilityAI)
+			addWalls();
+		world.aiSlices[utilityAI ? UtilityAISubsystem : BehaviorTreeSubsystem].budgetMs = aiBudgetsMs[aiBudget];
+
+		// Builds the trees and profile now rather than in the middle of the first tick
+		behaviorTree(ScoutTree);
+		defaultUtilityProfile();
+		const int columns = 50;
+		const int rows = 30;
+		uint32_t brain = (utilityAI ? UtilityBit : BehaviorTreeBit) | (aiLod ? AiLodBit : 0) | (sleeping ? SleepBit : 0);
+		world.reserve(agentComponents | brain, columns * rows);
+		world.timers.reserve(columns * rows);
+		for (int y = 0; y < rows; y++) {
+			for (int x = 0; x < columns; x++) {
+				EntityHandle agent = spawnAgent(brain, Vector2{ (x + 0.5f) * width / columns, (y + 0.5f) * height / rows }, 4.0f, 2.5f, player);
+				// Staggered over the first interval ticks so a tenth of them are scored each tick
+				if (utilityAI)
+					startUtilityTimer(world, agent, 1 + (y * columns + x) % world.get<UtilityAgent>(agent)->interval);
+				else
+					world.get<BehaviorTreeAgent>(agent)->tree = (x + y) % 3 == 0 ? SkittishTree : ScoutTree;
+				if (aiLod)
+					world.get<AiLod>(agent)->phase = (y * columns + x) % 8;
+			}
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void EcsScenarios::displayDebug() {
+	scheduler.run(systems, world);
+	scheduler.drawStats(10, GetScreenHeight() - 130);
+	if (currentScenario == EcsBlended)
+		drawPriorityCounters(world, 10, GetScreenHeight() - 155);
+	if (currentScenario == EcsBehaviorTrees && aiLod)
+		drawAiLodStats(10, GetScreenHeight() - 180);
+	if (currentScenario == EcsBehaviorTrees && sleeping)
+		drawSleepStats(10, GetScreenHeight() - 230);
+	if (currentScenario == EcsBehaviorTrees && aiBudget > 0) {
+		AiSubsystem subsystem = utilityAI ? UtilityAISubsystem : BehaviorTreeSubsystem;
+		world.aiSlices[subsystem].drawStats(utilityAI ? "Utility AI" : "Behavior trees", 10, GetScreenHeight() - 205);
+	}
+	if (currentScenario == EcsBehaviorTrees && utilityAI)
+		drawUtilityAIStats(10, GetScreenHeight() - 155);
+	else if (currentScenario == EcsBehaviorTrees)
+		drawBehaviorTreeStats(10, GetScreenHeight() - 155);
+	if (currentScenario == EcsThreats) {
+		int evaders = 0;
+		int threats = 0;
+		world.forEachArchetype(EvasionBit, [&evaders, &threats](Archetype& a) {
+			for (int i = 0; i < a.size(); i++, evaders++)
+				threats += a.evasions[i].threatCount;
+		});
+		DrawText(TextFormat("Threats considered per evader: %.1f", evaders > 0 ? (float)threats / evaders : 0.0f), 10, GetScreenHeight() - 155, 20, RED);
+	}
+	DrawText(TextFormat("%d/%d Type: %s (ECS, %d entities)", currentScenario + 1, EcsScenarioCount, systems.name, world.entityCount()),
+		10, GetScreenHeight() - 50, 20, RED);
+}
+
+void EcsScenarios::browseStates() {
+	const int keys[EcsScenarioCount] = { KEY_ONE, KEY_TWO, KEY_THREE, KEY_FOUR, KEY_FIVE, KEY_SIX, KEY_SEVEN, KEY_EIGHT, KEY_NINE, KEY_ZERO };
+	for (int i = 0; i < EcsScenarioCount; i++) {
+		if (IsKeyPressed(keys[i]) && currentScenario != i)
+			load((EcsScenarioType)i);
+	}
+
+	if (IsKeyPressed(KEY_T))
+		scheduler.parallel = !scheduler.parallel;
+
+	// Swapping the composition reorders the passes, so the scenario is simply loaded again
+	if (IsKeyPressed(KEY_B) && currentScenario == EcsBlended) {
+		world.steeringComposition = world.steeringComposition == PriorityComposition ? BlendedComposition : PriorityComposition;
+		load(EcsBlended);
+	}
+	if (IsKeyPressed(KEY_U) && currentScenario == EcsBehaviorTrees) {
+		utilityAI = !utilityAI;
+		load(EcsBehaviorTrees);
+	}
+	if (IsKeyPressed(KEY_L) && currentScenario == EcsBehaviorTrees) {
+		aiLod = !aiLod;
+		load(EcsBehaviorTrees);
+	}
+	if (IsKeyPressed(KEY_Z) && currentScenario == EcsBehaviorTrees) {
+		sleeping = !sleeping;
+		load(EcsBehaviorTrees);
+	}
+	// Like a noise going off where the player is
+	if (IsKeyPressed(KEY_SPACE) && currentScenario == EcsBehaviorTrees) {
+		world.forEachArchetype(PositionBit | PlayerInputBit, [this](Archetype& a) {
+			for (int i = 0; i < a.size(); i++)
+				world.wakeEvents.push_back(WakeEvent{ a.positions[i].value, 250.0f });
+		});
+	}
+	// No reload, so the starvation numbers show how the agents catch up
+	if (IsKeyPressed(KEY_K) && currentScenario == EcsBehaviorTrees) {
+		// The slice that had no budget yet sizes its bookkeeping on its first run
+		AllocationTracker::markTransition();
+		aiBudget = (aiBudget + 1) % aiBudgetCount;
+		world.aiSlices[utilityAI ? UtilityAISubsystem : BehaviorTreeSubsystem].budgetMs = aiBudgetsMs[aiBudget];
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "raylib.h"
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+#include "SystemScheduler.h"
+
+// Part 3: the composed scenarios from part 2 again, but built from ECS entities and system sets.
+// The last one mixes jumping, separation and path following which would have needed a new class before.
+enum EcsScenarioType {
+	EcsPathfollow,
+	EcsSeparation,
+	EcsWallAvoidance,
+	EcsJumping,
+	EcsMixed,
+	EcsBlended,
+	EcsCrowd,
+	EcsThreats,
+	EcsInfluence,
+	EcsBehaviorTrees,
+	EcsScenarioCount,
+};
+
+struct EcsScenarios {
+	World world;
+	EcsScenarioType currentScenario;
+	SystemSet systems;
+	SystemScheduler scheduler;
+	// U switches the last scenario from behavior trees to utility AI
+	bool utilityAI = false;
+	// L turns AI LOD off in the last scenario, to compare against everyone steering every tick
+	bool aiLod = true;
+	// Z turns off putting settled agents to sleep in the last scenario
+	bool sleeping = true;
+	// K cycles the per tick time budget of the last scenario's decision making through these, 0 is no budget
+	static constexpr int aiBudgetCount = 4;
+	static constexpr float aiBudgetsMs[aiBudgetCount] = { 0.0f, 0.1f, 0.03f, 0.01f };
+	int aiBudget = 0;
+
+	EcsScenarios();
+
+	void load(EcsScenarioType scenario);
+	void displayDebug();
+	void browseStates();
+
+private:
+	EntityHandle spawnPlayer(Vector2 position, float speed);
+	EntityHandle spawnAgent(uint32_t extraComponents, Vector2 position, float radius, float speed, EntityHandle target);
+	void addWalls();
+	void addPads();
+};
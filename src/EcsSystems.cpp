@@ -0,0 +1,416 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "EcsSystems.h"
+#include "TargetPrediction.h"
+
+void SystemSet::run(World& world) {
+	for (System& system : systems)
+		system.run(world);
+	world.tick++;
+	world.timers.advance();
+}
+
+void playerInputSystem(World& world) {
+	world.forEachArchetype(PositionBit | VelocityBit | PlayerInputBit, [](Archetype& a) {
+		int x = 0;
+		int y = 0;
+		if (IsKeyDown(KEY_W)) y -= 1;
+		if (IsKeyDown(KEY_S)) y += 1;
+		if (IsKeyDown(KEY_A)) x -= 1;
+		if (IsKeyDown(KEY_D)) x += 1;
+
+		for (int i = 0; i < a.size(); i++) {
+			a.velocities[i].value = Vector2{ x * a.playerInputs[i].speed, y * a.playerInputs[i].speed };
+			a.positions[i].value += a.velocities[i].value;
+		}
+	});
+}
+
+// Scratch for the bulk handle lookups, only ever grows
+static std::vector<EntityHandle> targetHandles;
+static std::vector<uint32_t> targetDense;
+
+// Copies every agent's target entity position/velocity into its Steering component.
+// All of an archetype's handles are resolved in one resolveAll pass.
+void targetSystem(World& world) {
+	world.forEachArchetype(SteeringBit, [&world](Archetype& a) {
+		int count = a.size();
+		targetHandles.resize(count);
+		targetDense.resize(count);
+		for (int i = 0; i < count; i++)
+			targetHandles[i] = a.steerings[i].target;
+		world.locations.resolveAll(targetHandles.data(), targetDense.data(), count);
+
+		for (int i = 0; i < count; i++) {
+			Steering& steering = a.steerings[i];
+			steering.hasTarget = false;
+			if (targetDense[i] == HandleTable<EntityLocation>::noDense)
+				continue;
+
+			const EntityLocation& location = world.locations.dense[targetDense[i]];
+			Archetype& targetArchetype = world.archetypes[location.archetype];
+			if (!(targetArchetype.mask & PositionBit))
+				continue;
+			steering.targetPosition = targetArchetype.positions[location.row].value;
+			steering.targetVelocity = (targetArchetype.mask & VelocityBit) ? targetArchetype.velocities[location.row].value : Vector2{ 0, 0 };
+			steering.hasTarget = true;
+		}
+	});
+}
+
+// Same as PathfollowAgent, walk the nodes one by one and make a new path after the last one
+void pathFollowSystem(World& world) {
+	float width = GetScreenWidth();
+	float height = GetScreenHeight();
+
+	uint32_t tick = world.tick;
+	world.forEachArchetype(PositionBit | SteeringBit | PathBit, [width, height, tick](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			Path& path = a.paths[i];
+			if (path.nodeCount == 0) {
+				path.nodeCount = path.maximumPathCount < Path::maxNodes ? path.maximumPathCount : Path::maxNodes;
+				uint64_t key = entityRandomKey(a.entities[i]);
+				for (int n = 0; n < path.nodeCount; n++) {
+					path.nodes[n] = Vector2{ (float)randomRange(key, randomCounter(tick, n * 2), 0, width),
+						(float)randomRange(key, randomCounter(tick, n * 2 + 1), 0, height) };
+				}
+				path.currentNode = 0;
+			}
+
+			if (Vector2Length(a.positions[i].value - path.nodes[path.currentNode]) <= 10) {
+				path.currentNode++;
+				if (path.currentNode >= path.nodeCount) {
+					path.currentNode = 0;
+					path.nodeCount = 0;
+					continue;
+				}
+			}
+
+			a.steerings[i].targetPosition = path.nodes[path.currentNode];
+			a.steerings[i].targetVelocity = Vector2{ 0, 0 };
+			a.steerings[i].hasTarget = true;
+		}
+	});
+}
+
+// Same whisker test as ObjectAvoidance::avoidWalls, but instead of repointing at a dummy object
+// It just overrides the steering target position
+void wallAvoidanceSystem(World& world) {
+	if (world.walls.empty())
+		return;
+
+	const std::vector<EcsWall>& walls = world.walls;
+	world.forEachArchetype(PositionBit | OrientationBit | SteeringBit | ColliderBit, [&walls](Archetype& a) {
+		const float rayLength = 150.0f;
+		const float fovAngle = 45.0f * DEG2RAD;
+
+		for (int i = 0; i < a.size(); i++) {
+			Vector2 position = a.positions[i].value;
+			Vector2 forward = Vector2Normalize(a.orientations[i].forward);
+			Vector2 whiskers[3] = {
+				position + forward * rayLength,
+				position + Vector2Rotate(forward, +fovAngle) * rayLength / 2,
+				position + Vector2Rotate(forward, -fovAngle) * rayLength / 2,
+			};
+
+			bool raycastHit = false;
+			Vector2 avoidDir = forward;
+			for (int w = 0; w < walls.size() && !raycastHit; w++) {
+				Vector2 mid = (walls[w].start + walls[w].end) * 0.5f;
+				for (int k = 0; k < 3; k++) {
+					if (Vector2Distance(whiskers[k], mid) < a.colliders[i].radius + 50.0f) {
+						avoidDir = Vector2Normalize(position - mid);
+						raycastHit = true;
+						break;
+					}
+				}
+			}
+
+			if (raycastHit) {
+				a.steerings[i].targetPosition = position + avoidDir * rayLength;
+				a.steerings[i].targetVelocity = Vector2{ 0, 0 };
+				a.steerings[i].hasTarget = true;
+			}
+		}
+	});
+}
+
+// Flat copies of everything with a collider so the pair loop doesn't care about archetypes
+static std::vector<Vector2*> separationPositions;
+static std::vector<float> separationRadii;
+static std::vector<float> separationScales;
+static std::vector<uint8_t> separationAsleep;
+
+// Same position push as SeparatedAgents::handleCollision
+void separationSystem(World& world) {
+	separationPositions.clear();
+	separationRadii.clear();
+	separationScales.clear();
+	separationAsleep.clear();
+	world.forEachArchetype(PositionBit | ColliderBit | SteeringBit, [](Archetype& a) {
+		bool sleeps = a.has(SleepBit);
+		for (int i = 0; i < a.size(); i++) {
+			separationPositions.push_back(&a.positions[i].value);
+			separationRadii.push_back(a.colliders[i].radius);
+			separationScales.push_back(a.colliders[i].separationScale);
+			separationAsleep.push_back(sleeps && a.sleeps[i].asleep);
+		}
+	});
+
+	int count = separationPositions.size();
+	for (int i = 0; i < count; i++) {
+		// Only i gets pushed, so a sleeping agent has nothing to do here. It still pushes the awake ones
+		if (separationAsleep[i])
+			continue;
+		for (int j = i + 1; j < count; j++) {
+			Vector2 diff = *separationPositions[i] - *separationPositions[j];
+			float distSq = diff.x * diff.x + diff.y * diff.y;
+
+			float minimumDistance = (separationRadii[i] + separationRadii[j]) * separationScales[i];
+			if (distSq < minimumDistance * minimumDistance && distSq > 0.0f) {
+				float dist = sqrtf(distSq);
+				*separationPositions[i] += (diff / dist) * ((minimumDistance - dist) * 0.5f);
+			}
+		}
+	}
+}
+
+static bool isOnPad(const EcsPad& pad, Vector2 position, float radius) {
+	return position.x + radius >= pad.position.x
+		&& position.x - radius <= pad.position.x + pad.size.x
+		&& position.y + radius >= pad.position.y
+		&& position.y - radius <= pad.position.y + pad.size.y;
+}
+
+// JumpingAgent::checkPads and applyJumpPhysics for every entity with a JumpState
+void jumpSystem(World& world) {
+	const std::vector<EcsPad>& pads = world.pads;
+	world.forEachArchetype(PositionBit | ColliderBit | JumpBit, [&pads](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			JumpState& jump = a.jumps[i];
+			Collider& collider = a.colliders[i];
+			Vector2& position = a.positions[i].value;
+
+			bool grounded = jump.zPosition <= 0.0f;
+			for (const EcsPad& pad : pads) {
+				if (!isOnPad(pad, position, collider.baseRadius))
+					continue;
+				if (pad.type == JumpPad && grounded && !jump.hasJumped) {
+					jump.jumpSpeed = 10.0f;
+					jump.hasJumped = true;
+				}
+				else if (pad.type == DeathPad && grounded) {
+					position = jump.spawnPoint;
+				}
+			}
+
+			if (jump.hasJumped) {
+				jump.zPosition += jump.jumpSpeed;
+				jump.jumpSpeed -= jump.gravity;
+
+				if (jump.zPosition <= 0.0f) {
+					jump.zPosition = 0.0f;
+					jump.jumpSpeed = 0.0f;
+					jump.hasJumped = false;
+					collider.radius = collider.baseRadius;
+				}
+				else {
+					collider.radius = collider.baseRadius * (1.0f + (jump.zPosition * 0.008f));
+				}
+			}
+		}
+	});
+}
+
+// Turns the orientation towards a direction with the behavior's smoothness, like the Agent behaviors do.
+// steps is how many ticks this covers (More than 1 for agents on a lower AI LOD), it turns as far as that many ticks would have
+static void rotateTowards(Orientation& orientation, Vector2 toTarget, int steps) {
+	float desiredRotation = orientation.angle;
+	if (Vector2Length(toTarget) > 0.001f)
+		desiredRotation = atan2f(toTarget.y, toTarget.x);
+
+	float delta = desiredRotation - orientation.angle;
+	if (delta > PI) delta -= 2 * PI;
+	else if (delta < -PI) delta += 2 * PI;
+
+	float smoothness = steps == 1 ? orientation.rotationSmoothness : 1.0f - powf(1.0f - orientation.rotationSmoothness, (float)steps);
+	orientation.angle += delta * smoothness;
+	orientation.forward = { cosf(orientation.angle), sinf(orientation.angle) };
+}
+
+static void accelerate(Velocity& velocity, Position& position, Vector2 desiredVelocity, float maxSteering, int steps) {
+	Vector2 steering = Vector2ClampValue(desiredVelocity - velocity.value, 0, maxSteering * steps);
+	velocity.value += steering;
+	position.value += velocity.value;
+}
+
+// The Agent.cpp behaviors as one switch over the Behaviors enum, no virtual calls
+// wanderStep is this tick's -1/0/1 random draw, only Wander uses it.
+// predicted is the pursue/evade direction from the batched kernel (TargetPrediction.h), only those two use it.
+// steps is how many ticks of steering this is, see AiLod.h
+static void steer(Position& position, Velocity& velocity, Orientation& orientation, Steering& steering, int wanderStep, Vector2 predicted, int steps) {
+	Vector2 toTarget = steering.targetPosition - position.value;
+
+	switch (steering.behavior) {
+	case Seek:
+	case Flee:
+	case Pursue:
+	case Evade: {
+		orientation.rotationSmoothness = 0.2f;
+		Vector2 direction = toTarget;
+		if (steering.behavior == Flee) direction = position.value - steering.targetPosition;
+		else if (steering.behavior == Pursue || steering.behavior == Evade) direction = predicted;
+
+		rotateTowards(orientation, direction, steps);
+		accelerate(velocity, position, orientation.forward * steering.speed, 0.2f, steps);
+		break;
+	}
+	case Arrive: {
+		float distance = Vector2Length(toTarget);
+		orientation.rotationSmoothness = 0.12f;
+		rotateTowards(orientation, toTarget, steps);
+
+		float slowdownSpeed = steering.speed;
+		if (distance < 200)
+			slowdownSpeed = ((distance / 200) * steering.speed) - 2.0f;
+		if (slowdownSpeed <= 0.2f)
+			slowdownSpeed = 0;
+
+		accelerate(velocity, position, orientation.forward * slowdownSpeed, 0.1f, steps);
+		break;
+	}
+	case Wander: {
+		const float wanderOffset = 250;
+		const float wanderRadius = 35;
+		const float wanderRate = 1.0f;
+		orientation.rotationSmoothness = 0.2f;
+
+		steering.state.wanderOrientation += wanderStep * wanderRate;
+		float targetOrientation = steering.state.wanderOrientation + orientation.angle;
+		Vector2 target = position.value + Vector2{ cosf(orientation.angle), sinf(orientation.angle) } * wanderOffset;
+		target += Vector2{ cosf(targetOrientation), sinf(targetOrientation) } * wanderRadius;
+
+		rotateTowards(orientation, target - position.value, steps);
+		accelerate(velocity, position, orientation.forward * steering.speed, 0.5f, steps);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static PredictionLanes predictionLanes;
+
+// Agents with an Acceleration component go through the blended pipeline instead (SteeringPipeline.h),
+// Agents with Avoidance through the ORCA planner (Orca.h)
+void steeringSystem(World& world) {
+	uint32_t tick = world.tick;
+	world.forEachArchetype(PositionBit | VelocityBit | OrientationBit | SteeringBit, AccelerationBit | AvoidanceBit, [tick](Archetype& a) {
+		// targetSystem already snapshotted every target into Steering, so the whole archetype's
+		// Pursue/Evade predictions are one pass over flat lanes (Other behaviors get sign 0 and ignore it)
+		int count = a.size();
+		predictionLanes.resize(count);
+		for (int i = 0; i < count; i++) {
+			const Steering& steering = a.steerings[i];
+			predictionLanes.x[i] = a.positions[i].value.x;
+			predictionLanes.y[i] = a.positions[i].value.y;
+			predictionLanes.speed[i] = steering.speed;
+			predictionLanes.sign[i] = steering.behavior == Pursue ? 1.0f : (steering.behavior == Evade ? -1.0f : 0.0f);
+			predictionLanes.targetX[i] = steering.targetPosition.x;
+			predictionLanes.targetY[i] = steering.targetPosition.y;
+			predictionLanes.targetVelocityX[i] = steering.targetVelocity.x;
+			predictionLanes.targetVelocityY[i] = steering.targetVelocity.y;
+		}
+		predictionLanes.predict(count);
+
+		bool lod = a.has(AiLodBit);
+		bool sleeps = a.has(SleepBit);
+		for (int i = 0; i < count; i++) {
+			// Asleep (Sleep.h), it isn't moving until something wakes it
+			if (sleeps && a.sleeps[i].asleep)
+				continue;
+
+			// Not due on its AI LOD, so it just keeps going the way it was
+			int steps = 1;
+			if (lod) {
+				AiLod& aiLod = a.aiLods[i];
+				if (!aiLod.due) {
+					a.positions[i].value += a.velocities[i].value;
+					aiLod.ticksSkipped++;
+					continue;
+				}
+				steps = aiLod.ticksSkipped + 1;
+				aiLod.ticksSkipped = 0;
+			}
+
+			// Wander doesn't need a target, everything else does
+			bool wander = a.steerings[i].behavior == Wander;
+			if (!a.steerings[i].hasTarget && !wander)
+				continue;
+			int wanderStep = wander ? randomRange(entityRandomKey(a.entities[i]), tick, -1, 1) : 0;
+			Vector2 predicted = { predictionLanes.directionX[i], predictionLanes.directionY[i] };
+			steer(a.positions[i], a.velocities[i], a.orientations[i], a.steerings[i], wanderStep, predicted, steps);
+		}
+	});
+}
+
+// Agent::OutOfBoundsChecker, only for agents like before (the player isn't wrapped)
+void boundsSystem(World& world) {
+	float width = GetScreenWidth();
+	float height = GetScreenHeight();
+
+	world.forEachArchetype(PositionBit | SteeringBit, [width, height](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			Vector2& position = a.positions[i].value;
+			if (position.x > width) position.x = 0;
+			else if (position.x < 0) position.x = width;
+
+			if (position.y > height) position.y = 0;
+			else if (position.y < 0) position.y = height;
+		}
+	});
+}
+
+void renderSystem(World& world) {
+	for (const EcsPad& pad : world.pads)
+		DrawRectangle(pad.position.x, pad.position.y, pad.size.x, pad.size.y, pad.type == JumpPad ? Color{ 100, 100, 100, 105 } : Color{ 255, 50, 50, 105 });
+
+	for (const EcsWall& wall : world.walls)
+		DrawLine(wall.start.x, wall.start.y, wall.end.x, wall.end.y, GREEN);
+
+	world.forEachArchetype(PathBit, [](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			const Path& path = a.paths[i];
+			for (int n = 0; n < path.nodeCount; n++) {
+				DrawCircleLines(path.nodes[n].x, path.nodes[n].y, 10, DARKPURPLE);
+				if (n < path.nodeCount - 1)
+					DrawLine(path.nodes[n].x, path.nodes[n].y, path.nodes[n + 1].x, path.nodes[n + 1].y, DARKPURPLE);
+			}
+		}
+	});
+
+	world.forEachArchetype(PositionBit | ColliderBit, [](Archetype& a) {
+		bool sleeps = a.has(SleepBit);
+		Color color = GREEN;
+		if (a.mask & PlayerInputBit) color = BLUE;
+		else if (a.mask & ThreatBit) color = ORANGE;
+		else if (a.mask & InfluenceSourceBit) color = (a.mask & SteeringBit) ? MAROON : GOLD;
+		for (int i = 0; i < a.size(); i++) {
+			Vector2 position = a.positions[i].value;
+			DrawCircle(position.x, position.y, a.colliders[i].radius, sleeps && a.sleeps[i].asleep ? DARKGREEN : color);
+			if (a.mask & OrientationBit)
+				DrawLineV(position, position + a.orientations[i].forward * 50.0f, RED);
+		}
+	});
+}
+
+const System PlayerInputPhase = { "playerInput", playerInputSystem, PlayerInputBit | ScreenResource, PositionBit | VelocityBit, MainThreadOnly };
+const System TargetPhase = { "target", targetSystem, PositionBit | VelocityBit, SteeringBit, NoSystemFlags };
+const System PathFollowPhase = { "pathFollow", pathFollowSystem, PositionBit, SteeringBit | PathBit, NoSystemFlags };
+const System WallAvoidancePhase = { "wallAvoidance", wallAvoidanceSystem, PositionBit | OrientationBit | ColliderBit | WallsResource, SteeringBit, NoSystemFlags };
+const System SeparationPhase = { "separation", separationSystem, ColliderBit | SleepBit, PositionBit, NoSystemFlags };
+const System JumpPhase = { "jump", jumpSystem, PadsResource, PositionBit | ColliderBit | JumpBit, NoSystemFlags };
+const System SteeringPhase = { "steering", steeringSystem, SleepBit, PositionBit | VelocityBit | OrientationBit | SteeringBit | AiLodBit, NoSystemFlags };
+const System BoundsPhase = { "bounds", boundsSystem, NoSystemFlags, PositionBit, NoSystemFlags };
+const System RenderPhase = { "render", renderSystem, PositionBit | OrientationBit | ColliderBit | PathBit | SleepBit | WallsResource | PadsResource, ScreenResource, MainThreadOnly };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+
+#include "Ecs.h"
+#include "Random.h"
+
+// A system is a plain function over the world, it picks the archetypes it cares about with a component mask.
+// A scenario is then nothing more than a list of systems plus the entities it spawns,
+// So a new mix (Say jumping + separation + path following) is just another list, no new class.
+typedef void (*SystemFunction)(World& world);
+
+// Shared data that isn't a component column, declared in reads/writes the same way as components
+// (Plain constants rather than an enum so they can be or'ed with ComponentBit)
+// They sit in the top byte so there's room for ComponentBit to keep growing below them
+const uint32_t WallsResource = 1 << 24;
+const uint32_t PadsResource = 1 << 25;
+// Drawing and raylib input, which have to stay on the main thread anyway
+const uint32_t ScreenResource = 1 << 26;
+const uint32_t InfluenceResource = 1 << 27;
+const uint32_t TimersResource = 1 << 28;
+
+// Random stream of an entity (Random.h), the generation is in there so a reused slot gets new numbers
+inline uint64_t entityRandomKey(EntityHandle entity) {
+	return randomKey(((uint64_t)entity.generation << 32) | entity.index);
+}
+
+// Agents numbered over every archetype with the required components in turn, like TimeSlice numbers them.
+// Calls f(archetype, begin, end) for the rows of each archetype that fall inside the range
+template<typename F>
+void forEachRowRange(World& world, uint32_t required, int begin, int end, F f) {
+	int offset = 0;
+	world.forEachArchetype(required, [&](Archetype& a) {
+		int from = begin - offset > 0 ? begin - offset : 0;
+		int to = end - offset < a.size() ? end - offset : a.size();
+		if (from < to)
+			f(a, from, to);
+		offset += a.size();
+	});
+}
+
+const uint32_t NoSystemFlags = 0;
+// Has to run on the thread that owns the window (drawing, input)
+const uint32_t MainThreadOnly = 1 << 0;
+
+// reads/writes are ComponentBit | ResourceBit masks. The scheduler (SystemScheduler.h) uses them
+// To work out which systems can run at the same time, two systems conflict if one writes what the other touches.
+struct System {
+	const char* name;
+	SystemFunction run;
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t flags;
+};
+
+struct SystemSet {
+	const char* name;
+	std::vector<System> systems;
+
+	void run(World& world);
+};
+
+// Descriptors for the systems below, these are what scenarios put in their SystemSet
+extern const System PlayerInputPhase;
+extern const System TargetPhase;
+extern const System PathFollowPhase;
+extern const System WallAvoidancePhase;
+extern const System SeparationPhase;
+extern const System JumpPhase;
+extern const System SteeringPhase;
+extern const System BoundsPhase;
+extern const System RenderPhase;
+
+// The systems, roughly in the order they run in
+void playerInputSystem(World& world);
+void targetSystem(World& world);
+void pathFollowSystem(World& world);
+void wallAvoidanceSystem(World& world);
+void separationSystem(World& world);
+void jumpSystem(World& world);
+void steeringSystem(World& world);
+void boundsSystem(World& world);
+void renderSystem(World& world);
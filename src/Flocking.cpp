@@ -0,0 +1,154 @@
+#include <chrono>
+
+#include "Flocking.h"
+
+static double nowMs() {
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+NeighbourLists::NeighbourLists(float _cutoff, float _skin) : cutoff(_cutoff), skin(_skin), valid(false), frames(0), rebuilds(0), rebuildMs(0) {}
+
+void NeighbourLists::reserve(int maxAgents) {
+	referencePositions.reserve(maxAgents);
+	listStart.reserve(maxAgents + 1);
+	neighbours.reserve(maxAgents * maxAgents);
+}
+
+void NeighbourLists::invalidate() {
+	valid = false;
+}
+
+bool NeighbourLists::needsRebuild(const std::vector<Agent*>& agents) const {
+	if (!valid || referencePositions.size() != agents.size())
+		return true;
+
+	// Two agents closing in on each other can each cover half the skin
+	float limitSq = skin * skin * 0.25f;
+	for (int i = 0; i < agents.size(); i++) {
+		if (Vector2DistanceSqr(agents[i]->position, referencePositions[i]) > limitSq)
+			return true;
+	}
+	return false;
+}
+
+void NeighbourLists::rebuild(const std::vector<Agent*>& agents) {
+	double start = nowMs();
+	int count = agents.size();
+	float rangeSq = (cutoff + skin) * (cutoff + skin);
+
+	referencePositions.resize(count);
+	for (int i = 0; i < count; i++)
+		referencePositions[i] = agents[i]->position;
+
+	// Plain all pairs search, fine for the agent counts here since it only runs now and then
+	listStart.resize(count + 1);
+	neighbours.clear();
+	for (int i = 0; i < count; i++) {
+		listStart[i] = neighbours.size();
+		for (int j = 0; j < count; j++) {
+			if (j != i && Vector2DistanceSqr(referencePositions[i], referencePositions[j]) < rangeSq)
+				neighbours.push_back(j);
+		}
+	}
+	listStart[count] = neighbours.size();
+
+	valid = true;
+	rebuilds++;
+	rebuildMs = (float)(nowMs() - start);
+}
+
+bool NeighbourLists::update(const std::vector<Agent*>& agents) {
+	frames++;
+	if (!needsRebuild(agents))
+		return false;
+	rebuild(agents);
+	return true;
+}
+
+Flock::Flock() : lists(150.0f, 40.0f), queryMs(0), averageCandidates(0), averageNeighbours(0) {}
+
+void Flock::reserve(int maxAgents) {
+	lists.reserve(maxAgents);
+	forces.reserve(maxAgents);
+}
+
+void Flock::update(std::vector<Agent*>& agents, Object* target) {
+	lists.update(agents);
+
+	double start = nowMs();
+	int count = agents.size();
+	float cutoffSq = lists.cutoff * lists.cutoff;
+	float separationSq = separationRadius * separationRadius;
+	int candidates = 0;
+	int neighbourCount = 0;
+	forces.resize(count);
+
+	for (int i = 0; i < count; i++) {
+		Agent& agent = *agents[i];
+		Vector2 separation = { 0, 0 };
+		Vector2 averageVelocity = { 0, 0 };
+		Vector2 centre = { 0, 0 };
+		int inRange = 0;
+
+		for (int n = lists.listStart[i]; n < lists.listStart[i + 1]; n++) {
+			const Agent& other = *agents[lists.neighbours[n]];
+			Vector2 away = agent.position - other.position;
+			float distSq = Vector2LengthSqr(away);
+			candidates++;
+			if (distSq >= cutoffSq)
+				continue;
+
+			inRange++;
+			averageVelocity += other.velocity;
+			centre += other.position;
+			// Closer neighbours push harder
+			if (distSq < separationSq && distSq > 0.0001f)
+				separation += away / distSq;
+		}
+		neighbourCount += inRange;
+
+		// Reynolds style: each rule wants a velocity, the force is the difference to the current one
+		Vector2 force = { 0, 0 };
+		if (inRange > 0) {
+			averageVelocity = averageVelocity / (float)inRange;
+			centre = centre / (float)inRange;
+			if (Vector2LengthSqr(separation) > 0.0f)
+				force += Vector2ClampValue(Vector2Normalize(separation) * agent.speed - agent.velocity, 0.0f, maxForce) * separationWeight;
+			force += Vector2ClampValue(averageVelocity - agent.velocity, 0.0f, maxForce) * alignmentWeight;
+			force += Vector2ClampValue(Vector2Normalize(centre - agent.position) * agent.speed - agent.velocity, 0.0f, maxForce) * cohesionWeight;
+		}
+		if (target)
+			force += Vector2ClampValue(Vector2Normalize(target->position - agent.position) * agent.speed - agent.velocity, 0.0f, maxForce) * seekWeight;
+
+		forces[i] = Vector2ClampValue(force, 0.0f, maxForce);
+	}
+
+	// Smoothed since a single frame is only a few microseconds
+	queryMs = queryMs * 0.95f + (float)(nowMs() - start) * 0.05f;
+	if (count > 0) {
+		averageCandidates = averageCandidates * 0.95f + ((float)candidates / count) * 0.05f;
+		averageNeighbours = averageNeighbours * 0.95f + ((float)neighbourCount / count) * 0.05f;
+	}
+
+	for (int i = 0; i < count; i++) {
+		Agent& agent = *agents[i];
+		agent.velocity = Vector2ClampValue(agent.velocity + forces[i], 0.0f, agent.speed);
+		agent.position += agent.velocity;
+		if (Vector2LengthSqr(agent.velocity) > 0.0001f) {
+			float delta = atan2f(agent.velocity.y, agent.velocity.x) - agent.orientation;
+			if (delta > PI) delta -= 2 * PI;
+			else if (delta < -PI) delta += 2 * PI;
+			agent.orientation += delta * agent.rotationSmoothness;
+			agent.forwardDirection = { cosf(agent.orientation), sinf(agent.orientation) };
+		}
+	}
+}
+
+void Flock::drawStats(int x, int y) {
+	float rebuildRate = lists.frames > 0 ? 100.0f * lists.rebuilds / lists.frames : 0.0f;
+	DrawText(TextFormat("Flocking (F to toggle): lists rebuilt %d of %d frames (%.1f%%), last rebuild %.4f ms",
+		lists.rebuilds, lists.frames, rebuildRate, lists.rebuildMs), x, y, 20, RED);
+	DrawText(TextFormat("Query %.4f ms/frame, %.1f candidates and %.1f neighbours per agent",
+		queryMs, averageCandidates, averageNeighbours), x, y + 25, 20, RED);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <vector>
+
+#include "Agent.h"
+
+// Verlet style neighbour lists.
+// Each agent keeps a list of everyone within cutoff + skin of it at the last rebuild. As long as nobody has moved
+// More than skin / 2 since then, anyone within cutoff now must already be on the list, so the lists stay valid
+// And a frame only has to filter them instead of searching every other agent.
+struct NeighbourLists {
+	float cutoff;
+	float skin;
+	// Positions at the last rebuild, to measure how far everyone has moved since
+	std::vector<Vector2> referencePositions;
+	// Agent i's neighbours are neighbours[listStart[i]] .. neighbours[listStart[i + 1]]
+	std::vector<int> listStart;
+	std::vector<int> neighbours;
+	bool valid;
+
+	// Measured, shown by Flock::drawStats
+	int frames;
+	int rebuilds;
+	float rebuildMs;
+
+	NeighbourLists(float _cutoff, float _skin);
+
+	// Reserves for the worst case (everyone neighbours everyone) so rebuilding never allocates
+	void reserve(int maxAgents);
+	// Has to be called whenever agents are added, removed or reordered
+	void invalidate();
+	// Rebuilds if needed, returns true if it did
+	bool update(const std::vector<Agent*>& agents);
+	void rebuild(const std::vector<Agent*>& agents);
+	bool needsRebuild(const std::vector<Agent*>& agents) const;
+};
+
+// Boids (Reynolds): separation, alignment and cohesion from the neighbour lists above,
+// Plus a weak seek towards the player so the flock stays around
+struct Flock {
+	NeighbourLists lists;
+	float separationRadius = 75.0f;
+	float separationWeight = 1.5f;
+	float alignmentWeight = 1.0f;
+	float cohesionWeight = 0.8f;
+	float seekWeight = 0.4f;
+	float maxForce = 0.15f;
+	// Scratch so every agent's force comes from the same frame
+	std::vector<Vector2> forces;
+
+	// Per frame cost of walking the lists, smoothed
+	float queryMs;
+	float averageCandidates;
+	float averageNeighbours;
+
+	Flock();
+
+	void reserve(int maxAgents);
+	void update(std::vector<Agent*>& agents, Object* target);
+	void drawStats(int x, int y);
+};
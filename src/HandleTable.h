@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Generational handle: index into the table's slots plus the generation the slot had when it was handed out.
+// When the entity is removed the slot's generation is bumped, so old handles to it simply stop resolving
+// Instead of dangling like a raw pointer would.
+struct EntityHandle {
+	uint32_t index;
+	uint32_t generation;
+
+	static EntityHandle invalid() {
+		return EntityHandle{ UINT32_MAX, 0 };
+	}
+
+	bool isNull() const {
+		return index == UINT32_MAX;
+	}
+
+	bool operator==(const EntityHandle& other) const {
+		return index == other.index && generation == other.generation;
+	}
+
+	bool operator!=(const EntityHandle& other) const {
+		return !(*this == other);
+	}
+};
+
+// Slot map: handles point at slots, slots point at a dense array of values.
+// The dense array never has holes (removal swaps the last value into the gap),
+// So it can be iterated directly and values can be reordered for locality with swapDense()
+// Without any handle held elsewhere changing.
+template<typename T>
+struct HandleTable {
+	static constexpr uint32_t noDense = UINT32_MAX;
+
+	std::vector<uint32_t> slotGeneration;
+	std::vector<uint32_t> slotDense;
+	std::vector<uint32_t> freeSlots;
+
+	std::vector<T> dense;
+	std::vector<uint32_t> denseToSlot;
+
+	void reserve(size_t count) {
+		slotGeneration.reserve(count);
+		slotDense.reserve(count);
+		freeSlots.reserve(count);
+		dense.reserve(count);
+		denseToSlot.reserve(count);
+	}
+
+	EntityHandle insert(const T& value) {
+		uint32_t slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			slot = (uint32_t)slotGeneration.size();
+			slotGeneration.push_back(0);
+			slotDense.push_back(noDense);
+		}
+
+		slotDense[slot] = (uint32_t)dense.size();
+		dense.push_back(value);
+		denseToSlot.push_back(slot);
+		return EntityHandle{ slot, slotGeneration[slot] };
+	}
+
+	bool remove(EntityHandle handle) {
+		uint32_t denseIndex = resolve(handle);
+		if (denseIndex == noDense)
+			return false;
+
+		uint32_t last = (uint32_t)dense.size() - 1;
+		if (denseIndex != last) {
+			dense[denseIndex] = dense[last];
+			denseToSlot[denseIndex] = denseToSlot[last];
+			slotDense[denseToSlot[denseIndex]] = denseIndex;
+		}
+		dense.pop_back();
+		denseToSlot.pop_back();
+
+		slotDense[handle.index] = noDense;
+		slotGeneration[handle.index]++;
+		freeSlots.push_back(handle.index);
+		return true;
+	}
+
+	// Dense index for a handle, or noDense if the handle is stale
+	uint32_t resolve(EntityHandle handle) const {
+		if (handle.index >= slotGeneration.size() || slotGeneration[handle.index] != handle.generation)
+			return noDense;
+		return slotDense[handle.index];
+	}
+
+	bool valid(EntityHandle handle) const {
+		return resolve(handle) != noDense;
+	}
+
+	T* get(EntityHandle handle) {
+		uint32_t denseIndex = resolve(handle);
+		return denseIndex == noDense ? nullptr : &dense[denseIndex];
+	}
+
+	EntityHandle handleAt(uint32_t denseIndex) const {
+		uint32_t slot = denseToSlot[denseIndex];
+		return EntityHandle{ slot, slotGeneration[slot] };
+	}
+
+	// Bulk version of resolve() for hot loops, stale handles come out as noDense
+	void resolveAll(const EntityHandle* handles, uint32_t* outDense, int count) const {
+		const uint32_t slotCount = (uint32_t)slotGeneration.size();
+		for (int i = 0; i < count; i++) {
+			uint32_t slot = handles[i].index;
+			bool alive = slot < slotCount && slotGeneration[slot] == handles[i].generation;
+			outDense[i] = alive ? slotDense[slot] : noDense;
+		}
+	}
+
+	// Reorder the dense values, handles stay valid
+	void swapDense(uint32_t a, uint32_t b) {
+		if (a == b)
+			return;
+		T tmp = dense[a];
+		dense[a] = dense[b];
+		dense[b] = tmp;
+
+		uint32_t slotA = denseToSlot[a];
+		uint32_t slotB = denseToSlot[b];
+		denseToSlot[a] = slotB;
+		denseToSlot[b] = slotA;
+		slotDense[slotA] = b;
+		slotDense[slotB] = a;
+	}
+
+	int size() const {
+		return (int)dense.size();
+	}
+};
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+
+#include "InfluenceMap.h"
+
+// Binomial 1 4 6 4 1, the two outer taps and the two inner ones share a weight
+static const float blurOuter = 1.0f / 16.0f;
+static const float blurInner = 4.0f / 16.0f;
+static const float blurCentre = 6.0f / 16.0f;
+static const int blurRadius = 2;
+
+void InfluenceMap::resize(float width, float height, float _cellSize, int _kernelRadius) {
+	cellSize = _cellSize;
+	columns = (int)(width / cellSize) + 1;
+	rows = (int)(height / cellSize) + 1;
+	kernelRadius = _kernelRadius;
+
+	int side = 2 * kernelRadius + 1;
+	kernel.resize(side * side);
+	for (int y = -kernelRadius; y <= kernelRadius; y++) {
+		for (int x = -kernelRadius; x <= kernelRadius; x++) {
+			float distance = sqrtf((float)(x * x + y * y));
+			kernel[(y + kernelRadius) * side + x + kernelRadius] = fmaxf(0.0f, 1.0f - distance / (kernelRadius + 1));
+		}
+	}
+
+	for (int layer = 0; layer < InfluenceLayerCount; layer++) {
+		stamped[layer].resize(columns * rows);
+		blurred[layer].resize(columns * rows);
+	}
+	scratch.resize(columns * rows);
+	clear();
+}
+
+void InfluenceMap::clear() {
+	for (int layer = 0; layer < InfluenceLayerCount; layer++) {
+		std::fill(stamped[layer].begin(), stamped[layer].end(), 0.0f);
+		std::fill(blurred[layer].begin(), blurred[layer].end(), 0.0f);
+		dirtyMinX[layer] = columns;
+		dirtyMinY[layer] = rows;
+		dirtyMaxX[layer] = -1;
+		dirtyMaxY[layer] = -1;
+	}
+}
+
+int InfluenceMap::cellOf(Vector2 position) const {
+	int x = std::min(std::max((int)(position.x / cellSize), 0), columns - 1);
+	int y = std::min(std::max((int)(position.y / cellSize), 0), rows - 1);
+	return y * columns + x;
+}
+
+void InfluenceMap::markDirty(InfluenceLayer layer, int minX, int minY, int maxX, int maxY) {
+	dirtyMinX[layer] = std::min(dirtyMinX[layer], minX);
+	dirtyMinY[layer] = std::min(dirtyMinY[layer], minY);
+	dirtyMaxX[layer] = std::max(dirtyMaxX[layer], maxX);
+	dirtyMaxY[layer] = std::max(dirtyMaxY[layer], maxY);
+}
+
+void InfluenceMap::stamp(InfluenceLayer layer, int cell, float strength) {
+	int centreX = cell % columns;
+	int centreY = cell / columns;
+	int x0 = std::max(centreX - kernelRadius, 0), x1 = std::min(centreX + kernelRadius, columns - 1);
+	int y0 = std::max(centreY - kernelRadius, 0), y1 = std::min(centreY + kernelRadius, rows - 1);
+	int side = 2 * kernelRadius + 1;
+
+	std::vector<float>& values = stamped[layer];
+	for (int y = y0; y <= y1; y++) {
+		const float* kernelRow = &kernel[(y - centreY + kernelRadius) * side + (x0 - centreX + kernelRadius)];
+		float* row = &values[y * columns + x0];
+		for (int x = 0; x <= x1 - x0; x++)
+			row[x] += kernelRow[x] * strength;
+	}
+	cellsStamped += (x1 - x0 + 1) * (y1 - y0 + 1);
+	markDirty(layer, x0, y0, x1, y1);
+}
+
+// A changed stamp moves the blurred values up to blurRadius cells further out, and the blur of those
+// Needs the stamps another blurRadius out again. Edges clamp to the border cell
+void InfluenceMap::blurRegion(InfluenceLayer layer) {
+	int x0 = std::max(dirtyMinX[layer] - blurRadius, 0), x1 = std::min(dirtyMaxX[layer] + blurRadius, columns - 1);
+	int y0 = std::max(dirtyMinY[layer] - blurRadius, 0), y1 = std::min(dirtyMaxY[layer] + blurRadius, rows - 1);
+	int scratchY0 = std::max(y0 - blurRadius, 0), scratchY1 = std::min(y1 + blurRadius, rows - 1);
+	const std::vector<float>& source = stamped[layer];
+	std::vector<float>& target = blurred[layer];
+
+	// Horizontal, the middle of the row has all its taps in range so it's the straight line part
+	int innerX0 = std::max(x0, blurRadius), innerX1 = std::min(x1, columns - 1 - blurRadius);
+	for (int y = scratchY0; y <= scratchY1; y++) {
+		const float* in = &source[y * columns];
+		float* out = &scratch[y * columns];
+		for (int x = innerX0; x <= innerX1; x++)
+			out[x] = (in[x - 2] + in[x + 2]) * blurOuter + (in[x - 1] + in[x + 1]) * blurInner + in[x] * blurCentre;
+
+		for (int x = x0; x <= x1; x++) {
+			if (x >= innerX0 && x <= innerX1)
+				continue;
+			auto at = [in, this](int i) { return in[std::min(std::max(i, 0), columns - 1)]; };
+			out[x] = (at(x - 2) + at(x + 2)) * blurOuter + (at(x - 1) + at(x + 1)) * blurInner + at(x) * blurCentre;
+		}
+	}
+
+	// Vertical, five whole rows at a time so the inner loop is contiguous
+	for (int y = y0; y <= y1; y++) {
+		auto row = [this](int i) { return &scratch[std::min(std::max(i, 0), rows - 1) * columns]; };
+		const float* up2 = row(y - 2);
+		const float* up1 = row(y - 1);
+		const float* centre = row(y);
+		const float* down1 = row(y + 1);
+		const float* down2 = row(y + 2);
+		float* out = &target[y * columns];
+		for (int x = x0; x <= x1; x++)
+			out[x] = (up2[x] + down2[x]) * blurOuter + (up1[x] + down1[x]) * blurInner + centre[x] * blurCentre;
+	}
+	cellsBlurred += (x1 - x0 + 1) * (y1 - y0 + 1);
+}
+
+void InfluenceMap::propagate() {
+	for (int layer = 0; layer < InfluenceLayerCount; layer++) {
+		if (dirtyMaxX[layer] < dirtyMinX[layer])
+			continue;
+		blurRegion((InfluenceLayer)layer);
+		dirtyMinX[layer] = columns;
+		dirtyMinY[layer] = rows;
+		dirtyMaxX[layer] = -1;
+		dirtyMaxY[layer] = -1;
+	}
+}
+
+float InfluenceMap::sample(InfluenceLayer layer, Vector2 position) const {
+	return blurred[layer][cellOf(position)];
+}
+
+Vector2 InfluenceMap::gradient(InfluenceLayer layer, Vector2 position) const {
+	int cell = cellOf(position);
+	int x = cell % columns;
+	int y = cell / columns;
+	const std::vector<float>& values = blurred[layer];
+	float left = values[y * columns + std::max(x - 1, 0)];
+	float right = values[y * columns + std::min(x + 1, columns - 1)];
+	float up = values[std::max(y - 1, 0) * columns + x];
+	float down = values[std::min(y + 1, rows - 1) * columns + x];
+	return Vector2{ right - left, down - up } * 0.5f;
+}
+
+// Danger in red and opportunity in green, both faded by how strong they are
+void InfluenceMap::draw() {
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < columns; x++) {
+			// Taking stamps back out can leave tiny negatives behind
+			float danger = Clamp(blurred[DangerLayer][y * columns + x], 0.0f, 1.0f);
+			float opportunity = Clamp(blurred[OpportunityLayer][y * columns + x], 0.0f, 1.0f);
+			if (danger < 0.02f && opportunity < 0.02f)
+				continue;
+			Color color = { (unsigned char)(255 * danger), (unsigned char)(200 * opportunity), 0, (unsigned char)(90 * fmaxf(danger, opportunity)) };
+			DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize, color);
+		}
+	}
+}
+
+void InfluenceMap::drawStats(int x, int y) {
+	DrawText(TextFormat("Influence map %dx%d: %d sources restamped, %d cells stamped, %d cells blurred (Full rebuild: %d)",
+		columns, rows, sourcesRestamped, cellsStamped, cellsBlurred, columns * rows * InfluenceLayerCount), x, y, 20, RED);
+}
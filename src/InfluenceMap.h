@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+#include "raymath.h"
+
+enum InfluenceLayer {
+	DangerLayer,
+	OpportunityLayer,
+	InfluenceLayerCount,
+};
+
+// Grid of danger and opportunity over the screen that agents can look up in O(1).
+// Every source stamps a kernel (Falling off linearly with distance) into its layer. The stamps are kept incremental:
+// A source only touches the map when it moves into another cell, and then just subtracts its old kernel and adds the new one,
+// So the cost follows how many sources moved rather than cells * sources.
+// Stamped layers are then smoothed with a separable 5 tap blur, but only over the rectangle the stamps changed.
+// The blur loops run over contiguous rows with no branches in the middle so the compiler vectorises them
+// (Same idea as randomRanges).
+struct InfluenceMap {
+	float cellSize = 25.0f;
+	int columns = 0, rows = 0;
+	// Kernel is (2 * kernelRadius + 1)^2 cells
+	int kernelRadius = 0;
+	std::vector<float> kernel;
+
+	std::vector<float> stamped[InfluenceLayerCount];
+	std::vector<float> blurred[InfluenceLayerCount];
+	std::vector<float> scratch;
+
+	// Cells changed since the last propagate, per layer, inclusive. dirtyMaxX < dirtyMinX means nothing changed
+	int dirtyMinX[InfluenceLayerCount], dirtyMinY[InfluenceLayerCount];
+	int dirtyMaxX[InfluenceLayerCount], dirtyMaxY[InfluenceLayerCount];
+
+	// Per frame, shown by drawStats
+	int sourcesRestamped = 0;
+	int cellsStamped = 0;
+	int cellsBlurred = 0;
+
+	void resize(float width, float height, float cellSize, int kernelRadius);
+	void clear();
+
+	int cellOf(Vector2 position) const;
+	// Adds strength times the kernel centred on cell, a negative strength takes an earlier stamp back out
+	void stamp(InfluenceLayer layer, int cell, float strength);
+	// Brings the blurred layers up to date with the stamps
+	void propagate();
+
+	float sample(InfluenceLayer layer, Vector2 position) const;
+	// Central difference over the neighbouring cells, points uphill
+	Vector2 gradient(InfluenceLayer layer, Vector2 position) const;
+
+	void draw();
+	void drawStats(int x, int y);
+
+private:
+	void markDirty(InfluenceLayer layer, int minX, int minY, int maxX, int maxY);
+	void blurRegion(InfluenceLayer layer);
+};
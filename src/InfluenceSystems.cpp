@@ -0,0 +1,65 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "InfluenceSystems.h"
+
+void influenceStampSystem(World& world) {
+	InfluenceMap& map = world.influence;
+	map.sourcesRestamped = 0;
+	map.cellsStamped = 0;
+	map.cellsBlurred = 0;
+
+	world.forEachArchetype(PositionBit | InfluenceSourceBit, [&map](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			InfluenceSource& source = a.influenceSources[i];
+			int cell = map.cellOf(a.positions[i].value);
+			if (cell == source.stampedCell && source.strength == source.stampedStrength)
+				continue;
+
+			if (source.stampedCell >= 0)
+				map.stamp(source.layer, source.stampedCell, -source.stampedStrength);
+			map.stamp(source.layer, cell, source.strength);
+			source.stampedCell = cell;
+			source.stampedStrength = source.strength;
+			map.sourcesRestamped++;
+		}
+	});
+	map.propagate();
+}
+
+void influenceSenseSystem(World& world) {
+	const InfluenceMap& map = world.influence;
+
+	world.forEachArchetype(PositionBit | SteeringBit | InfluenceSensingBit, [&map](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			Vector2 position = a.positions[i].value;
+			Steering& steering = a.steerings[i];
+			const InfluenceSensing& sensing = a.influenceSensings[i];
+
+			float danger = map.sample(DangerLayer, position);
+			float opportunity = map.sample(OpportunityLayer, position);
+			bool flee = danger > opportunity * sensing.courage;
+			Vector2 uphill = map.gradient(flee ? DangerLayer : OpportunityLayer, position);
+
+			// Flat ground, nothing to run from or go for
+			if (Vector2LengthSqr(uphill) < 0.000001f) {
+				steering.behavior = Wander;
+				continue;
+			}
+			// Flee runs away from the target, so for both the target sits uphill
+			steering.behavior = flee ? Flee : Seek;
+			steering.targetPosition = position + Vector2Normalize(uphill) * sensing.lookahead;
+			steering.targetVelocity = Vector2{ 0, 0 };
+			steering.hasTarget = true;
+		}
+	});
+}
+
+void influenceDrawSystem(World& world) {
+	world.influence.draw();
+	world.influence.drawStats(10, GetScreenHeight() - 155);
+}
+
+const System InfluenceStampPhase = { "influenceStamp", influenceStampSystem, PositionBit, InfluenceSourceBit | InfluenceResource, NoSystemFlags };
+const System InfluenceSensePhase = { "influenceSense", influenceSenseSystem, PositionBit | InfluenceSensingBit | InfluenceResource, SteeringBit, NoSystemFlags };
+const System InfluenceDrawPhase = { "influenceDraw", influenceDrawSystem, InfluenceResource, ScreenResource, MainThreadOnly };
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// Systems around World::influence (InfluenceMap.h).
+// influenceStampSystem re-stamps only the sources that moved into another cell and then blurs what changed,
+// influenceSenseSystem has every InfluenceSensing agent look at its own cell: flee up the danger gradient if danger
+// Outweighs opportunity, otherwise seek up the opportunity gradient (Wander if there's nothing to go for).
+void influenceStampSystem(World& world);
+void influenceSenseSystem(World& world);
+void influenceDrawSystem(World& world);
+
+extern const System InfluenceStampPhase;
+extern const System InfluenceSensePhase;
+extern const System InfluenceDrawPhase;
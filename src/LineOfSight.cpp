@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+
+#include "LineOfSight.h"
+#include "ComposedAgents.h"
+
+LineOfSight::LineOfSight() {
+	cache.assign(cacheCapacity, CacheEntry{ emptyPair, { 0, 0 }, { 0, 0 }, true, 0 });
+}
+
+void LineOfSight::reserve(int maxQueries) {
+	queries.reserve(maxQueries);
+}
+
+void LineOfSight::setWalls(const std::vector<LineWall>& walls) {
+	int count = walls.size();
+	wallStart.resize(count);
+	wallEnd.resize(count);
+	wallTestedBy.assign(count, 0);
+	rayCount = 0;
+	for (CacheEntry& entry : cache)
+		entry.pair = emptyPair;
+	totalQueries = 0;
+	totalHits = 0;
+
+	if (count == 0) {
+		columns = 0;
+		rows = 0;
+		return;
+	}
+
+	Vector2 maxPoint = walls[0].start;
+	gridMin = walls[0].start;
+	for (int i = 0; i < count; i++) {
+		wallStart[i] = walls[i].start;
+		wallEnd[i] = walls[i].end;
+		gridMin = Vector2Min(gridMin, Vector2Min(walls[i].start, walls[i].end));
+		maxPoint = Vector2Max(maxPoint, Vector2Max(walls[i].start, walls[i].end));
+	}
+	columns = (int)((maxPoint.x - gridMin.x) / cellSize) + 1;
+	rows = (int)((maxPoint.y - gridMin.y) / cellSize) + 1;
+
+	// Each wall goes into every cell its bounding box touches, a bit more than it actually crosses
+	// But the exact segment test sorts that out and the walls are short
+	auto forEachWallCell = [this](int wall, auto f) {
+		Vector2 low = Vector2Min(wallStart[wall], wallEnd[wall]) - gridMin;
+		Vector2 high = Vector2Max(wallStart[wall], wallEnd[wall]) - gridMin;
+		for (int cy = (int)(low.y / cellSize); cy <= (int)(high.y / cellSize); cy++)
+			for (int cx = (int)(low.x / cellSize); cx <= (int)(high.x / cellSize); cx++)
+				f(cy * columns + cx);
+	};
+
+	// Same counting sort as SpatialGrid, just with walls that can be in more than one cell
+	int cells = columns * rows;
+	cellStart.assign(cells + 1, 0);
+	for (int i = 0; i < count; i++)
+		forEachWallCell(i, [this](int cell) { cellStart[cell]++; });
+	for (int c = 1; c <= cells; c++)
+		cellStart[c] += cellStart[c - 1];
+	wallIndices.resize(cellStart[cells]);
+	for (int i = count - 1; i >= 0; i--)
+		forEachWallCell(i, [this, i](int cell) { wallIndices[--cellStart[cell]] = i; });
+}
+
+bool LineOfSight::segmentsCross(Vector2 a, Vector2 b, Vector2 c, Vector2 d) const {
+	Vector2 ab = b - a;
+	Vector2 cd = d - c;
+	float d1 = ab.x * (c.y - a.y) - ab.y * (c.x - a.x);
+	float d2 = ab.x * (d.y - a.y) - ab.y * (d.x - a.x);
+	float d3 = cd.x * (a.y - c.y) - cd.y * (a.x - c.x);
+	float d4 = cd.x * (b.y - c.y) - cd.y * (b.x - c.x);
+	// Lying along the wall doesn't count as blocked
+	if (d1 == 0 && d2 == 0)
+		return false;
+	return d1 * d2 <= 0 && d3 * d4 <= 0;
+}
+
+bool LineOfSight::castRay(Vector2 from, Vector2 to) {
+	if (columns == 0)
+		return true;
+	rayCount++;
+
+	// Clip the ray to the grid first, anything that misses it can't hit a wall
+	Vector2 direction = to - from;
+	Vector2 gridMax = gridMin + Vector2{ columns * cellSize, rows * cellSize };
+	float tEnter = 0.0f;
+	float tExit = 1.0f;
+	float origin[2] = { from.x, from.y };
+	float delta[2] = { direction.x, direction.y };
+	float low[2] = { gridMin.x, gridMin.y };
+	float high[2] = { gridMax.x, gridMax.y };
+	for (int axis = 0; axis < 2; axis++) {
+		if (fabsf(delta[axis]) < 0.0001f) {
+			if (origin[axis] < low[axis] || origin[axis] > high[axis])
+				return true;
+			continue;
+		}
+		float t0 = (low[axis] - origin[axis]) / delta[axis];
+		float t1 = (high[axis] - origin[axis]) / delta[axis];
+		tEnter = fmaxf(tEnter, fminf(t0, t1));
+		tExit = fminf(tExit, fmaxf(t0, t1));
+	}
+	if (tEnter > tExit)
+		return true;
+
+	Vector2 entry = from + direction * tEnter - gridMin;
+	int cx = std::min(std::max((int)(entry.x / cellSize), 0), columns - 1);
+	int cy = std::min(std::max((int)(entry.y / cellSize), 0), rows - 1);
+	int stepX = direction.x > 0 ? 1 : -1;
+	int stepY = direction.y > 0 ? 1 : -1;
+	// Ray parameter t at the next vertical / horizontal cell border, and how much t one whole cell takes
+	float tMaxX = direction.x != 0 ? (gridMin.x + (cx + (stepX > 0)) * cellSize - from.x) / direction.x : INFINITY;
+	float tMaxY = direction.y != 0 ? (gridMin.y + (cy + (stepY > 0)) * cellSize - from.y) / direction.y : INFINITY;
+	float tDeltaX = direction.x != 0 ? fabsf(cellSize / direction.x) : INFINITY;
+	float tDeltaY = direction.y != 0 ? fabsf(cellSize / direction.y) : INFINITY;
+
+	while (true) {
+		cellsVisited++;
+		int cell = cy * columns + cx;
+		for (int e = cellStart[cell]; e < cellStart[cell + 1]; e++) {
+			int wall = wallIndices[e];
+			if (wallTestedBy[wall] == rayCount)
+				continue;
+			wallTestedBy[wall] = rayCount;
+			if (segmentsCross(from, to, wallStart[wall], wallEnd[wall]))
+				return false;
+		}
+
+		if (fminf(tMaxX, tMaxY) > tExit)
+			return true;
+		if (tMaxX < tMaxY) {
+			cx += stepX;
+			tMaxX += tDeltaX;
+		}
+		else {
+			cy += stepY;
+			tMaxY += tDeltaY;
+		}
+		if (cx < 0 || cx >= columns || cy < 0 || cy >= rows)
+			return true;
+	}
+}
+
+int LineOfSight::request(uint32_t viewer, uint32_t target, Vector2 from, Vector2 to) {
+	if (answered) {
+		queries.clear();
+		answered = false;
+	}
+	queries.push_back(Query{ ((uint64_t)viewer << 32) | target, from, to, true });
+	return queries.size() - 1;
+}
+
+// Either the pair's entry, or the slot it should go in (An empty one, otherwise the least recently used within the probes)
+LineOfSight::CacheEntry* LineOfSight::findEntry(uint64_t pair) {
+	uint32_t home = (uint32_t)((pair * 0x9E3779B97F4A7C15ull) >> 32) & (cacheCapacity - 1);
+	CacheEntry* victim = nullptr;
+	for (int probe = 0; probe < maxProbes; probe++) {
+		CacheEntry& entry = cache[(home + probe) & (cacheCapacity - 1)];
+		if (entry.pair == pair)
+			return &entry;
+		if (!victim || (victim->pair != emptyPair && (entry.pair == emptyPair || entry.lastUsed < victim->lastUsed)))
+			victim = &entry;
+	}
+	return victim;
+}
+
+void LineOfSight::resolve() {
+	frame++;
+	hits = 0;
+	raysCast = 0;
+	cellsVisited = 0;
+	float thresholdSq = moveThreshold * moveThreshold;
+
+	for (Query& query : queries) {
+		CacheEntry* entry = findEntry(query.pair);
+		if (entry->pair == query.pair
+			&& Vector2DistanceSqr(entry->from, query.from) <= thresholdSq
+			&& Vector2DistanceSqr(entry->to, query.to) <= thresholdSq) {
+			// Positions stay the ones it was tested from, otherwise slow movement would creep past the threshold unnoticed
+			query.visible = entry->visible;
+			entry->lastUsed = frame;
+			hits++;
+			continue;
+		}
+		query.visible = castRay(query.from, query.to);
+		raysCast++;
+		*entry = CacheEntry{ query.pair, query.from, query.to, query.visible, frame };
+	}
+
+	totalQueries += queries.size();
+	totalHits += hits;
+	answered = true;
+}
+
+void LineOfSight::drawStats(int x, int y) {
+	float hitRate = totalQueries > 0 ? 100.0f * totalHits / totalQueries : 0.0f;
+	DrawText(TextFormat("Line of sight (L to toggle): %d queries, %d cached, %d rays over %d cells, %.0f%% cache hit rate",
+		(int)queries.size(), hits, raysCast, cellsVisited, hitRate), x, y, 20, RED);
+}
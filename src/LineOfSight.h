@@ -0,0 +1,83 @@
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <cstdint>
+#include <vector>
+
+struct LineWall;
+
+// Line of sight checks against a set of LineWalls.
+// Everything that wants to know if it can see something requests it during the frame and resolve() answers them in one go.
+// The walls are bucketed into a uniform grid once (They don't move), a ray then only steps through the cells it crosses
+// (Amanatides & Woo grid traversal) and tests the walls in those, stopping at the first hit.
+// On top of that every (viewer, target) pair remembers its last answer, and as long as neither end has moved
+// More than moveThreshold since it was tested the old answer is reused instead of casting again.
+struct LineOfSight {
+	float cellSize = 100.0f;
+	float moveThreshold = 8.0f;
+
+	// Walls as flat segments, cell c holds wallIndices[cellStart[c]] .. wallIndices[cellStart[c + 1]]
+	std::vector<Vector2> wallStart;
+	std::vector<Vector2> wallEnd;
+	std::vector<int> cellStart;
+	std::vector<int> wallIndices;
+	// Mailbox so a wall spanning several cells is only tested once per ray
+	std::vector<uint32_t> wallTestedBy;
+	uint32_t rayCount = 0;
+	Vector2 gridMin = { 0, 0 };
+	int columns = 0, rows = 0;
+
+	struct Query {
+		uint64_t pair;
+		Vector2 from;
+		Vector2 to;
+		bool visible;
+	};
+	std::vector<Query> queries;
+	// Set by resolve, the next request starts a new batch
+	bool answered = false;
+
+	// Fixed size open addressing table so a settled frame never allocates, pairs that stop being asked for get overwritten
+	struct CacheEntry {
+		uint64_t pair;
+		Vector2 from;
+		Vector2 to;
+		bool visible;
+		uint32_t lastUsed;
+	};
+	static constexpr int cacheCapacity = 1024;
+	static constexpr int maxProbes = 8;
+	static constexpr uint64_t emptyPair = UINT64_MAX;
+	std::vector<CacheEntry> cache;
+	uint32_t frame = 0;
+
+	// Per frame, shown by drawStats
+	int hits = 0;
+	int raysCast = 0;
+	int cellsVisited = 0;
+	// Since the walls were set
+	uint64_t totalQueries = 0;
+	uint64_t totalHits = 0;
+
+	LineOfSight();
+
+	// Rebuilds the grid and throws the cache away
+	void setWalls(const std::vector<LineWall>& walls);
+	void reserve(int maxQueries);
+
+	// viewer and target are any ids that stay the same for the same thing across frames, returns the query index
+	int request(uint32_t viewer, uint32_t target, Vector2 from, Vector2 to);
+	// Answers everything requested since the last resolve, read them back with visible(query)
+	void resolve();
+	bool visible(int query) const { return queries[query].visible; }
+
+	// Uncached, just the grid walk
+	bool castRay(Vector2 from, Vector2 to);
+	void drawStats(int x, int y);
+
+private:
+	bool segmentsCross(Vector2 a, Vector2 b, Vector2 c, Vector2 d) const;
+	CacheEntry* findEntry(uint64_t pair);
+};
@@ -0,0 +1,326 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "Orca.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+
+// A half plane of allowed velocities, everything to the right of direction through point is allowed
+struct OrcaLine {
+	Vector2 point;
+	Vector2 direction;
+};
+
+static const int maxOrcaNeighbours = 16;
+static const int maxOrcaWalls = 8;
+static const int maxOrcaLines = maxOrcaNeighbours + maxOrcaWalls;
+static const float orcaEpsilon = 0.00001f;
+
+static float det(Vector2 a, Vector2 b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+// Solves along one line, the lines before it are already satisfied by the current result
+static bool linearProgram1(const OrcaLine* lines, int lineNo, float radius, Vector2 optVelocity, bool directionOpt, Vector2& result) {
+	const OrcaLine& line = lines[lineNo];
+	float dotProduct = Vector2DotProduct(line.point, line.direction);
+	float discriminant = dotProduct * dotProduct + radius * radius - Vector2LengthSqr(line.point);
+	// The max speed circle misses the line completely
+	if (discriminant < 0.0f)
+		return false;
+
+	float sqrtDiscriminant = sqrtf(discriminant);
+	float tLeft = -dotProduct - sqrtDiscriminant;
+	float tRight = -dotProduct + sqrtDiscriminant;
+
+	for (int i = 0; i < lineNo; i++) {
+		float denominator = det(line.direction, lines[i].direction);
+		float numerator = det(lines[i].direction, line.point - lines[i].point);
+
+		// Parallel lines, either this one is fully outside the other or the other doesn't matter
+		if (fabsf(denominator) <= orcaEpsilon) {
+			if (numerator < 0.0f)
+				return false;
+			continue;
+		}
+
+		float t = numerator / denominator;
+		if (denominator >= 0.0f)
+			tRight = fminf(tRight, t);
+		else
+			tLeft = fmaxf(tLeft, t);
+
+		if (tLeft > tRight)
+			return false;
+	}
+
+	if (directionOpt) {
+		result = line.point + line.direction * (Vector2DotProduct(optVelocity, line.direction) > 0.0f ? tRight : tLeft);
+	}
+	else {
+		float t = Clamp(Vector2DotProduct(line.direction, optVelocity - line.point), tLeft, tRight);
+		result = line.point + line.direction * t;
+	}
+	return true;
+}
+
+// Returns lineCount on success, otherwise the line it failed on (result is then the best up to that line)
+static int linearProgram2(const OrcaLine* lines, int lineCount, float radius, Vector2 optVelocity, bool directionOpt, Vector2& result) {
+	if (directionOpt)
+		result = optVelocity * radius;
+	else if (Vector2LengthSqr(optVelocity) > radius * radius)
+		result = Vector2Normalize(optVelocity) * radius;
+	else
+		result = optVelocity;
+
+	for (int i = 0; i < lineCount; i++) {
+		if (det(lines[i].direction, lines[i].point - result) > 0.0f) {
+			Vector2 previous = result;
+			if (!linearProgram1(lines, i, radius, optVelocity, directionOpt, result)) {
+				result = previous;
+				return i;
+			}
+		}
+	}
+	return lineCount;
+}
+
+// Too crowded for every constraint to hold, so find the velocity that breaks the agent lines the least.
+// Wall lines (the first wallLines) are never relaxed
+static void linearProgram3(const OrcaLine* lines, int lineCount, int wallLines, int beginLine, float radius, Vector2& result) {
+	OrcaLine projectedLines[maxOrcaLines];
+	float distance = 0.0f;
+
+	for (int i = beginLine; i < lineCount; i++) {
+		if (det(lines[i].direction, lines[i].point - result) <= distance)
+			continue;
+
+		int projectedCount = 0;
+		for (int j = 0; j < wallLines; j++)
+			projectedLines[projectedCount++] = lines[j];
+
+		for (int j = wallLines; j < i; j++) {
+			OrcaLine line;
+			float determinant = det(lines[i].direction, lines[j].direction);
+			if (fabsf(determinant) <= orcaEpsilon) {
+				// Same direction, this one doesn't add anything
+				if (Vector2DotProduct(lines[i].direction, lines[j].direction) > 0.0f)
+					continue;
+				line.point = (lines[i].point + lines[j].point) * 0.5f;
+			}
+			else {
+				line.point = lines[i].point + lines[i].direction * (det(lines[j].direction, lines[i].point - lines[j].point) / determinant);
+			}
+			line.direction = Vector2Normalize(lines[j].direction - lines[i].direction);
+			projectedLines[projectedCount++] = line;
+		}
+
+		Vector2 previous = result;
+		if (linearProgram2(projectedLines, projectedCount, radius, Vector2{ -lines[i].direction.y, lines[i].direction.x }, true, result) < projectedCount)
+			result = previous;
+		distance = det(lines[i].direction, lines[i].point - result);
+	}
+}
+
+// Flat copy of everything that can be collided with. Only Avoidance agents get solved,
+// Everything else (the player) is just an obstacle that won't do its half
+static std::vector<float> orcaX;
+static std::vector<float> orcaY;
+static std::vector<Vector2> orcaVelocity;
+static std::vector<float> orcaRadius;
+static std::vector<float> orcaResponsibility;
+
+// The solved agents, as indices into the arrays above plus what they want
+static std::vector<int> solvedIndex;
+static std::vector<Vector2> solvedPreferred;
+static std::vector<Avoidance> solvedSettings;
+static std::vector<float> solvedSpeed;
+static std::vector<Vector2> solvedResult;
+
+static SpatialGrid orcaGrid;
+
+struct OrcaJob {
+	const SpatialGrid* grid;
+	const std::vector<EcsWall>* walls;
+};
+
+// Walls are static, so the agent takes the whole constraint: don't close the gap faster than wallTimeHorizon allows
+static int addWallLines(const std::vector<EcsWall>& walls, Vector2 position, float radius, const Avoidance& settings, OrcaLine* lines) {
+	float range = settings.neighbourDistance;
+	int count = 0;
+	for (const EcsWall& wall : walls) {
+		if (count == maxOrcaWalls)
+			break;
+		if (position.x < fminf(wall.start.x, wall.end.x) - range || position.x > fmaxf(wall.start.x, wall.end.x) + range ||
+			position.y < fminf(wall.start.y, wall.end.y) - range || position.y > fmaxf(wall.start.y, wall.end.y) + range)
+			continue;
+
+		Vector2 segment = wall.end - wall.start;
+		float t = Clamp(Vector2DotProduct(position - wall.start, segment) / fmaxf(Vector2LengthSqr(segment), 0.0001f), 0.0f, 1.0f);
+		Vector2 away = position - (wall.start + segment * t);
+		float distance = Vector2Length(away);
+		if (distance >= range || distance < 0.0001f)
+			continue;
+
+		Vector2 normal = away / distance;
+		float allowed = -(distance - radius) / settings.wallTimeHorizon;
+		lines[count++] = OrcaLine{ normal * allowed, Vector2{ normal.y, -normal.x } };
+	}
+	return count;
+}
+
+// The velocity obstacle of one neighbour turned into the half plane this agent is responsible for
+static OrcaLine agentLine(int self, int other, float timeHorizon) {
+	Vector2 relativePosition = { orcaX[other] - orcaX[self], orcaY[other] - orcaY[self] };
+	Vector2 velocity = orcaVelocity[self];
+	Vector2 relativeVelocity = velocity - orcaVelocity[other];
+	float distSq = Vector2LengthSqr(relativePosition);
+	float combinedRadius = orcaRadius[self] + orcaRadius[other];
+	float combinedRadiusSq = combinedRadius * combinedRadius;
+	float invTimeHorizon = 1.0f / timeHorizon;
+
+	OrcaLine line;
+	Vector2 u;
+	if (distSq > combinedRadiusSq) {
+		// Vector from the cutoff circle centre to the relative velocity
+		Vector2 w = relativeVelocity - relativePosition * invTimeHorizon;
+		float wLengthSq = Vector2LengthSqr(w);
+		float dotProduct = Vector2DotProduct(w, relativePosition);
+
+		if (dotProduct < 0.0f && dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
+			// Closest to the cutoff circle
+			float wLength = sqrtf(wLengthSq);
+			Vector2 unitW = w / wLength;
+			line.direction = Vector2{ unitW.y, -unitW.x };
+			u = unitW * (combinedRadius * invTimeHorizon - wLength);
+		}
+		else {
+			// Closest to one of the legs of the cone
+			float leg = sqrtf(distSq - combinedRadiusSq);
+			if (det(relativePosition, w) > 0.0f)
+				line.direction = Vector2{ relativePosition.x * leg - relativePosition.y * combinedRadius, relativePosition.x * combinedRadius + relativePosition.y * leg } / distSq;
+			else
+				line.direction = Vector2{ relativePosition.x * leg + relativePosition.y * combinedRadius, -relativePosition.x * combinedRadius + relativePosition.y * leg } / -distSq;
+			u = line.direction * Vector2DotProduct(relativeVelocity, line.direction) - relativeVelocity;
+		}
+	}
+	else {
+		// Already overlapping, get out within one frame
+		Vector2 w = relativeVelocity - relativePosition;
+		float wLength = fmaxf(Vector2Length(w), orcaEpsilon);
+		Vector2 unitW = w / wLength;
+		line.direction = Vector2{ unitW.y, -unitW.x };
+		u = unitW * (combinedRadius - wLength);
+	}
+
+	line.point = velocity + u * orcaResponsibility[other];
+	return line;
+}
+
+static void solveAgents(void* data, int begin, int end) {
+	const OrcaJob& job = *static_cast<OrcaJob*>(data);
+	OrcaLine lines[maxOrcaLines];
+	int neighbours[maxOrcaNeighbours];
+
+	for (int s = begin; s < end; s++) {
+		int self = solvedIndex[s];
+		const Avoidance& settings = solvedSettings[s];
+		Vector2 position = { orcaX[self], orcaY[self] };
+
+		int wallLines = addWallLines(*job.walls, position, orcaRadius[self], settings, lines);
+		int maxNeighbours = settings.maxNeighbours < maxOrcaNeighbours ? settings.maxNeighbours : maxOrcaNeighbours;
+		int neighbourCount = job.grid->findNearest(orcaX.data(), orcaY.data(), position.x, position.y, settings.neighbourDistance, maxNeighbours, neighbours, self);
+		int lineCount = wallLines;
+		for (int n = 0; n < neighbourCount; n++)
+			lines[lineCount++] = agentLine(self, neighbours[n], settings.timeHorizon);
+
+		Vector2 result;
+		int failed = linearProgram2(lines, lineCount, solvedSpeed[s], solvedPreferred[s], false, result);
+		if (failed < lineCount)
+			linearProgram3(lines, lineCount, wallLines, failed, solvedSpeed[s], result);
+		solvedResult[s] = result;
+	}
+}
+
+void reserveOrca(int maxAgents) {
+	orcaX.reserve(maxAgents);
+	orcaY.reserve(maxAgents);
+	orcaVelocity.reserve(maxAgents);
+	orcaRadius.reserve(maxAgents);
+	orcaResponsibility.reserve(maxAgents);
+	solvedIndex.reserve(maxAgents);
+	solvedPreferred.reserve(maxAgents);
+	solvedSettings.reserve(maxAgents);
+	solvedSpeed.reserve(maxAgents);
+	solvedResult.reserve(maxAgents);
+	orcaGrid.reserve(maxAgents);
+}
+
+void orcaSystem(World& world) {
+	orcaX.clear();
+	orcaY.clear();
+	orcaVelocity.clear();
+	orcaRadius.clear();
+	orcaResponsibility.clear();
+	solvedIndex.clear();
+	solvedPreferred.clear();
+	solvedSettings.clear();
+	solvedSpeed.clear();
+
+	float cellSize = 1.0f;
+	world.forEachArchetype(PositionBit | VelocityBit | ColliderBit, [&cellSize](Archetype& a) {
+		bool solved = a.has(AvoidanceBit | SteeringBit);
+		for (int i = 0; i < a.size(); i++) {
+			Vector2 position = a.positions[i].value;
+			if (solved) {
+				const Steering& steering = a.steerings[i];
+				// Seek (or flee) the target, slowing down close to it so a crowd can settle
+				const float slowRadius = 100.0f;
+				Vector2 toTarget = steering.targetPosition - position;
+				float distance = Vector2Length(toTarget);
+				float sign = (steering.behavior == Flee || steering.behavior == Evade) ? -1.0f : 1.0f;
+				float speed = steering.speed * (sign > 0.0f ? fminf(distance / slowRadius, 1.0f) : 1.0f);
+				Vector2 preferred = (steering.hasTarget && distance > 0.001f) ? toTarget * (sign * speed / distance) : Vector2{ 0, 0 };
+
+				solvedIndex.push_back(orcaX.size());
+				solvedPreferred.push_back(preferred);
+				solvedSettings.push_back(a.avoidances[i]);
+				solvedSpeed.push_back(steering.speed);
+				cellSize = fmaxf(cellSize, a.avoidances[i].neighbourDistance);
+			}
+			orcaX.push_back(position.x);
+			orcaY.push_back(position.y);
+			orcaVelocity.push_back(a.velocities[i].value);
+			orcaRadius.push_back(a.colliders[i].radius);
+			// Another ORCA agent takes half of the avoidance, anything else has to be avoided completely
+			orcaResponsibility.push_back(solved ? 0.5f : 1.0f);
+		}
+	});
+	if (solvedIndex.empty())
+		return;
+
+	orcaGrid.build(orcaX.data(), orcaY.data(), orcaX.size(), cellSize);
+	OrcaJob job = { &orcaGrid, &world.walls };
+	solvedResult.resize(solvedIndex.size());
+	ThreadPool::instance().parallelFor(solvedIndex.size(), 16, solveAgents, &job);
+
+	int index = 0;
+	world.forEachArchetype(PositionBit | VelocityBit | ColliderBit | AvoidanceBit | SteeringBit, [&index](Archetype& a) {
+		for (int i = 0; i < a.size(); i++, index++) {
+			Vector2 velocity = solvedResult[index];
+			a.velocities[i].value = velocity;
+			a.positions[i].value += velocity;
+
+			if (!(a.mask & OrientationBit) || Vector2LengthSqr(velocity) < 0.0001f)
+				continue;
+			Orientation& orientation = a.orientations[i];
+			float delta = atan2f(velocity.y, velocity.x) - orientation.angle;
+			if (delta > PI) delta -= 2 * PI;
+			else if (delta < -PI) delta += 2 * PI;
+			orientation.angle += delta * orientation.rotationSmoothness;
+			orientation.forward = { cosf(orientation.angle), sinf(orientation.angle) };
+		}
+	});
+}
+
+const System OrcaPhase = { "orca", orcaSystem, ColliderBit | SteeringBit | WallsResource, PositionBit | VelocityBit | OrientationBit, NoSystemFlags };
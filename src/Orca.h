@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// ORCA (optimal reciprocal collision avoidance) for agents with an Avoidance component.
+// SeparatedAgents::handleCollision pushes positions apart after the fact, which jitters and needs the
+// getMinDistance scale hacks. Here every agent instead picks the velocity closest to where it wants to go
+// That keeps it collision free for timeHorizon frames, assuming its neighbours do their half of the work.
+// Each neighbour and nearby wall is one half plane of allowed velocities, and the velocity is found with
+// A small 2D linear program (Same as the RVO2 library).
+//
+// Neighbours come from a uniform grid and are capped at maxNeighbours, so the cost per agent is bounded
+// And the whole thing is linear in agent count. Agents are solved in parallel through ThreadPool::parallelFor.
+
+// Preferred velocity from the Steering target, ORCA solve, then moves the agent with the result
+void orcaSystem(World& world);
+// Scratch space and grid for up to maxAgents colliders (Solved or not), call it when a scenario sets them up
+void reserveOrca(int maxAgents);
+
+extern const System OrcaPhase;
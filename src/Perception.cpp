@@ -0,0 +1,68 @@
+#include "Perception.h"
+
+void ConePerception::reserve(int maxAgents, int maxObjects) {
+	objectX.reserve(maxObjects);
+	objectY.reserve(maxObjects);
+	centroids.reserve(maxAgents);
+	counts.reserve(maxAgents);
+	grid.reserve(maxObjects);
+}
+
+void ConePerception::clearObjects() {
+	objectX.clear();
+	objectY.clear();
+}
+
+void ConePerception::addObject(Vector2 position) {
+	objectX.push_back(position.x);
+	objectY.push_back(position.y);
+}
+
+void ConePerception::perceive(const std::vector<Agent*>& agents, bool agentsAreObjects) {
+	int count = agents.size();
+	centroids.resize(count);
+	counts.resize(count);
+	grid.build(objectX.data(), objectY.data(), objectX.size(), range);
+
+	// Comparing squares keeps the sqrt out, which only works since the cone is narrower than 180 degrees
+	float rangeSq = range * range;
+	float cosine = cosf(halfAngle);
+	float cosineSq = cosine * cosine;
+	int candidates = 0;
+	agentsSeeingSomething = 0;
+
+	for (int i = 0; i < count; i++) {
+		Vector2 position = agents[i]->position;
+		// Straight from orientation, forwardDirection isn't set until the agent's first update
+		Vector2 forward = { cosf(agents[i]->orientation), sinf(agents[i]->orientation) };
+		int self = agentsAreObjects ? i : -1;
+		Vector2 sum = { 0, 0 };
+		int seen = 0;
+
+		grid.forEachCandidate(position.x, position.y, range, [&](int object) {
+			candidates++;
+			float dx = objectX[object] - position.x;
+			float dy = objectY[object] - position.y;
+			float distSq = dx * dx + dy * dy;
+			float along = dx * forward.x + dy * forward.y;
+			if (object == self || distSq >= rangeSq || along <= 0 || along * along < cosineSq * distSq)
+				return;
+			sum.x += objectX[object];
+			sum.y += objectY[object];
+			seen++;
+		});
+
+		counts[i] = seen;
+		centroids[i] = seen > 0 ? sum / (float)seen : position;
+		agentsSeeingSomething += seen > 0;
+	}
+
+	// Smoothed so the overlay is readable
+	float frameCandidates = count > 0 ? (float)candidates / count : 0.0f;
+	averageCandidates += (frameCandidates - averageCandidates) * 0.1f;
+}
+
+void ConePerception::drawStats(int x, int y) {
+	DrawText(TextFormat("View cones (V to toggle): %d agents see something, %.1f candidates checked per agent",
+		agentsSeeingSomething, averageCandidates), x, y, 20, RED);
+}
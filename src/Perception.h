@@ -0,0 +1,38 @@
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <vector>
+
+#include "Agent.h"
+#include "SpatialGrid.h"
+
+// Field of view cone perception, answering "what can this agent see in front of it" for every agent at once.
+// The objects go into one SpatialGrid, then each agent only walks the cells its range overlaps,
+// So the cost per agent follows how crowded it is around it rather than how many objects there are.
+// The result per agent is how many objects are in its cone and their centroid, which is what
+// ObstacleAndPlayerAvoidanceBehavior wants.
+struct ConePerception {
+	float range = 200.0f;
+	float halfAngle = 40.0f * DEG2RAD;
+
+	SpatialGrid grid;
+	std::vector<float> objectX;
+	std::vector<float> objectY;
+
+	// Per agent, valid after perceive
+	std::vector<Vector2> centroids;
+	std::vector<int> counts;
+
+	// Shown by drawStats
+	float averageCandidates = 0;
+	int agentsSeeingSomething = 0;
+
+	void reserve(int maxAgents, int maxObjects);
+	void clearObjects();
+	void addObject(Vector2 position);
+	// When agentsAreObjects is set, object i is taken to be agent i so nobody sees itself
+	void perceive(const std::vector<Agent*>& agents, bool agentsAreObjects);
+	void drawStats(int x, int y);
+};
@@ -3,6 +3,18 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "resource_dir.h"	
+#include "HandleTable.h"
+
+struct Object;
+
+// Every Object registers itself here so agents can refer to it by EntityHandle instead of a raw pointer
+// (See HandleTable.h), a despawned target then just fails to resolve.
+// Only targets go through it. Agents themselves stay Agent* in SeparatedAgents::agentList since nothing holds on
+// To an agent, so their storage isn't compacted
+inline HandleTable<Object*>& objectTable() {
+    static HandleTable<Object*> table;
+    return table;
+}
 
 
 // The reason player inherits from object, is so that the agent can get its position
@@ -17,14 +29,24 @@ struct Object {
     Vector2 velocity;
     float radius;
     float speed;
+    EntityHandle handle;
 
     Object(Vector2 startingPos, float startingRadius, float startingSpeed) {
         position = startingPos;
         radius = startingRadius;
         speed = startingSpeed;
         velocity = { 0, 0 };
+        handle = objectTable().insert(this);
     }
 
+    virtual ~Object() {
+        objectTable().remove(handle);
+    }
+
+    // A copy would share the handle, so objects can't be copied
+    Object(const Object&) = delete;
+    Object& operator=(const Object&) = delete;
+
     virtual void Update() {
         drawShape();
     }
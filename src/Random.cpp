@@ -0,0 +1,12 @@
+#include "Random.h"
+
+void randomRanges(const uint64_t* keys, uint64_t counter, int min, int max, int* out, int count) {
+	const int lanes = 8;
+	int full = count - count % lanes;
+	for (int begin = 0; begin < full; begin += lanes) {
+		for (int lane = 0; lane < lanes; lane++)
+			out[begin + lane] = randomRange(keys[begin + lane], counter, min, max);
+	}
+	for (int i = full; i < count; i++)
+		out[i] = randomRange(keys[i], counter, min, max);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+// Counter based random numbers, Widynski's "Squares" generator.
+// raylib's GetRandomValue is one global generator, so every caller advances the same state: the numbers an agent
+// Gets depend on who else drew before it, it can't be called from two threads and a run can't be reproduced.
+// Here a draw is a pure function of (seed, stream, counter). Every agent is its own stream (its id), the counter
+// Is the tick (plus which draw in that tick), so the same agent on the same tick always gets the same number
+// No matter which thread asks or in which order.
+
+// Changing this gives a different but still reproducible run
+inline uint32_t& randomSeed() {
+	static uint32_t seed = 0x5EED1234u;
+	return seed;
+}
+
+// splitmix64 finaliser, spreads (seed, stream) into a key with well mixed bits. Squares wants an odd key
+inline uint64_t randomKey(uint32_t seed, uint64_t stream) {
+	uint64_t z = ((uint64_t)seed << 32) ^ stream;
+	z += 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	z = z ^ (z >> 31);
+	return z | 1;
+}
+
+inline uint64_t randomKey(uint64_t stream) {
+	return randomKey(randomSeed(), stream);
+}
+
+// Four rounds of square, add, rotate (rotate by 32 is a swap of the halves)
+inline uint32_t randomBits(uint64_t key, uint64_t counter) {
+	uint64_t x = counter * key;
+	uint64_t y = x;
+	uint64_t z = y + key;
+	x = x * x + y; x = (x >> 32) | (x << 32);
+	x = x * x + z; x = (x >> 32) | (x << 32);
+	x = x * x + y; x = (x >> 32) | (x << 32);
+	return (uint32_t)((x * x + z) >> 32);
+}
+
+// Same range rules as GetRandomValue, min and max both included.
+// Multiply and shift instead of %, so there's no division in the hot loop
+inline int randomRange(uint64_t key, uint64_t counter, int min, int max) {
+	uint64_t span = (uint64_t)((int64_t)max - min) + 1;
+	return min + (int)(((uint64_t)randomBits(key, counter) * span) >> 32);
+}
+
+// [0, 1)
+inline float randomFloat(uint64_t key, uint64_t counter) {
+	return (randomBits(key, counter) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Counter for the n-th draw on a tick, so one tick can take several numbers from a stream
+inline uint64_t randomCounter(uint32_t tick, uint32_t draw) {
+	return ((uint64_t)tick << 32) | draw;
+}
+
+// randomRange for many streams on the same counter, eight lanes at a time.
+// Every lane does the exact same work with no branches, so the compiler can keep the lanes in vector registers
+void randomRanges(const uint64_t* keys, uint64_t counter, int min, int max, int* out, int count);
@@ -0,0 +1,140 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "Sleep.h"
+#include "SpatialGrid.h"
+
+// Velocity and target velocity both have to stay under this for ticksToSleep in a row
+static const float sleepSpeed = 0.05f;
+static const uint16_t ticksToSleep = 30;
+// How far the target can drift from where it was when the agent fell asleep
+static const float targetTolerance = 5.0f;
+// Gap between two colliders that still counts as touching
+static const float contactMargin = 2.0f;
+
+// Everything that's moving and could bump into a sleeper
+static std::vector<float> movingX;
+static std::vector<float> movingY;
+static std::vector<float> movingRadii;
+static SpatialGrid movingGrid;
+
+// From the last tick, for the overlay
+static int awakeCount = 0;
+static int asleepCount = 0;
+static int fellAsleep = 0;
+static int wokenByTarget = 0;
+static int wokenByContact = 0;
+static int wokenByEvent = 0;
+
+static bool targetChanged(const Sleep& sleep, const Steering& steering) {
+	if (!(steering.target == sleep.target) || steering.hasTarget != sleep.hadTarget)
+		return true;
+	return steering.hasTarget && (Vector2DistanceSqr(steering.targetPosition, sleep.targetPosition) > targetTolerance * targetTolerance
+		|| Vector2LengthSqr(steering.targetVelocity) > sleepSpeed * sleepSpeed);
+}
+
+static bool touched(Vector2 position, float radius, float maxMovingRadius) {
+	bool touching = false;
+	movingGrid.forEachCandidate(position.x, position.y, radius + maxMovingRadius + contactMargin, [&](int other) {
+		float reach = radius + movingRadii[other] + contactMargin;
+		float dx = movingX[other] - position.x;
+		float dy = movingY[other] - position.y;
+		touching |= dx * dx + dy * dy < reach * reach;
+	});
+	return touching;
+}
+
+static bool inWakeEvent(Vector2 position, const std::vector<WakeEvent>& events) {
+	for (const WakeEvent& event : events) {
+		if (Vector2DistanceSqr(position, event.position) < event.radius * event.radius)
+			return true;
+	}
+	return false;
+}
+
+void sleepSystem(World& world) {
+	awakeCount = 0;
+	asleepCount = 0;
+	fellAsleep = 0;
+	wokenByTarget = 0;
+	wokenByContact = 0;
+	wokenByEvent = 0;
+
+	// Room for everyone up front, how many are moving changes every tick and growing mid game would allocate
+	int candidates = 0;
+	world.forEachArchetype(PositionBit | VelocityBit | ColliderBit, [&candidates](Archetype& a) {
+		candidates += a.size();
+	});
+	movingX.clear();
+	movingY.clear();
+	movingRadii.clear();
+	movingX.reserve(candidates);
+	movingY.reserve(candidates);
+	movingRadii.reserve(candidates);
+	movingGrid.reserve(candidates);
+	float maxMovingRadius = 0.0f;
+	world.forEachArchetype(PositionBit | VelocityBit | ColliderBit, [&maxMovingRadius](Archetype& a) {
+		bool sleeps = a.has(SleepBit);
+		for (int i = 0; i < a.size(); i++) {
+			if ((sleeps && a.sleeps[i].asleep) || Vector2LengthSqr(a.velocities[i].value) < sleepSpeed * sleepSpeed)
+				continue;
+			movingX.push_back(a.positions[i].value.x);
+			movingY.push_back(a.positions[i].value.y);
+			movingRadii.push_back(a.colliders[i].radius);
+			maxMovingRadius = fmaxf(maxMovingRadius, a.colliders[i].radius);
+		}
+	});
+	movingGrid.build(movingX.data(), movingY.data(), movingX.size(), 50.0f);
+
+	world.forEachArchetype(PositionBit | VelocityBit | ColliderBit | SteeringBit | SleepBit, [&world, maxMovingRadius](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			Sleep& sleep = a.sleeps[i];
+			const Steering& steering = a.steerings[i];
+			Vector2 position = a.positions[i].value;
+
+			if (sleep.asleep) {
+				// Cheapest check first, the contact one has to look around
+				bool byTarget = targetChanged(sleep, steering);
+				bool byContact = !byTarget && touched(position, a.colliders[i].radius, maxMovingRadius);
+				bool byEvent = !byTarget && !byContact && inWakeEvent(position, world.wakeEvents);
+				if (!byTarget && !byContact && !byEvent) {
+					asleepCount++;
+					continue;
+				}
+				sleep.asleep = false;
+				sleep.quietTicks = 0;
+				wokenByTarget += byTarget;
+				wokenByContact += byContact;
+				wokenByEvent += byEvent;
+				awakeCount++;
+				continue;
+			}
+
+			bool quiet = Vector2LengthSqr(a.velocities[i].value) < sleepSpeed * sleepSpeed
+				&& Vector2LengthSqr(steering.targetVelocity) < sleepSpeed * sleepSpeed;
+			sleep.quietTicks = quiet ? sleep.quietTicks + 1 : 0;
+			if (sleep.quietTicks < ticksToSleep) {
+				awakeCount++;
+				continue;
+			}
+
+			sleep.asleep = true;
+			sleep.target = steering.target;
+			sleep.hadTarget = steering.hasTarget;
+			sleep.targetPosition = steering.targetPosition;
+			a.velocities[i].value = Vector2{ 0, 0 };
+			asleepCount++;
+			fellAsleep++;
+		}
+	});
+
+	world.wakeEvents.clear();
+}
+
+void drawSleepStats(int x, int y) {
+	int total = awakeCount + asleepCount;
+	DrawText(TextFormat("Sleeping (Z to toggle, Space wakes everyone near the player): %d awake, %d asleep (%.0f%%), %d fell asleep, woken by target %d, contact %d, event %d",
+		awakeCount, asleepCount, total > 0 ? 100.0f * asleepCount / total : 0.0f, fellAsleep, wokenByTarget, wokenByContact, wokenByEvent), x, y, 20, RED);
+}
+
+const System SleepPhase = { "sleep", sleepSystem, PositionBit | ColliderBit | SteeringBit, VelocityBit | SleepBit, NoSystemFlags };
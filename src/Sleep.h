@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// Sleeping for settled agents, like a physics engine puts resting bodies to sleep.
+// An agent with a Sleep component that has been (Nearly) standing still with a still target for a while falls asleep:
+// Its velocity is zeroed and the behavior tree, utility AI, steering and separation passes skip it.
+// It wakes up when
+//   - Its target changes: another entity, lost, moved away from where it was or started moving
+//   - Something moving touches it (An awake agent or the player, sleeping neighbours don't wake each other)
+//   - A WakeEvent in World::wakeEvents covers it
+// Run it after targetSystem so the target checks see this tick's target.
+void sleepSystem(World& world);
+void drawSleepStats(int x, int y);
+
+extern const System SleepPhase;
@@ -0,0 +1,80 @@
+#include <cmath>
+
+#include "SpatialGrid.h"
+
+void SpatialGrid::reserve(int maxPoints, int maxCellsPerSide) {
+	// The far edge rounds up to one more cell, so a side can have maxCellsPerSide + 1
+	int maxSide = maxCellsPerSide + 1;
+	cellStart.reserve(maxSide * maxSide + 1);
+	entries.reserve(maxPoints);
+	cellOf.reserve(maxPoints);
+}
+
+void SpatialGrid::build(const float* x, const float* y, int count, float _cellSize, int maxCellsPerSide) {
+	if (count <= 0) {
+		columns = 0;
+		rows = 0;
+		return;
+	}
+
+	minX = x[0];
+	minY = y[0];
+	float maxX = x[0];
+	float maxY = y[0];
+	for (int i = 1; i < count; i++) {
+		minX = fminf(minX, x[i]);
+		minY = fminf(minY, y[i]);
+		maxX = fmaxf(maxX, x[i]);
+		maxY = fmaxf(maxY, y[i]);
+	}
+	cellSize = fmaxf(_cellSize, fmaxf(maxX - minX, maxY - minY) / maxCellsPerSide);
+	columns = (int)((maxX - minX) / cellSize) + 1;
+	rows = (int)((maxY - minY) / cellSize) + 1;
+
+	int cells = columns * rows;
+	cellStart.assign(cells + 1, 0);
+	cellOf.resize(count);
+	entries.resize(count);
+	for (int i = 0; i < count; i++) {
+		cellOf[i] = cellY(y[i]) * columns + cellX(x[i]);
+		cellStart[cellOf[i]]++;
+	}
+	// Running sum makes each entry the end of its cell, filling back to front then walks it down to the start
+	for (int c = 1; c < cells; c++)
+		cellStart[c] += cellStart[c - 1];
+	cellStart[cells] = count;
+	for (int i = count - 1; i >= 0; i--)
+		entries[--cellStart[cellOf[i]]] = i;
+}
+
+// Keeps the k closest by inserting into a sorted list, once full the search range shrinks to the k-th
+int SpatialGrid::findNearest(const float* pointsX, const float* pointsY, float x, float y, float range, int k, int* out, int exclude) const {
+	float distances[maxNearest];
+	float rangeSq = range * range;
+	int found = 0;
+	k = k < maxNearest ? k : maxNearest;
+	if (k <= 0)
+		return 0;
+
+	forEachCandidate(x, y, range, [&](int other) {
+		if (other == exclude)
+			return;
+		float dx = pointsX[other] - x;
+		float dy = pointsY[other] - y;
+		float distSq = dx * dx + dy * dy;
+		if (distSq >= rangeSq)
+			return;
+
+		int slot = found < k ? found++ : k - 1;
+		while (slot > 0 && distances[slot - 1] > distSq) {
+			distances[slot] = distances[slot - 1];
+			out[slot] = out[slot - 1];
+			slot--;
+		}
+		distances[slot] = distSq;
+		out[slot] = other;
+		if (found == k)
+			rangeSq = distances[found - 1];
+	});
+	return found;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+// Uniform grid over a set of points, rebuilt from scratch whenever the points move.
+// Points are counting sorted by cell into one flat array, so a rebuild doesn't allocate once the vectors have grown
+// And a query only walks the cells overlapping its range.
+struct SpatialGrid {
+	float minX = 0, minY = 0;
+	float cellSize = 1;
+	int columns = 0, rows = 0;
+	// Cell c holds entries[cellStart[c]] .. entries[cellStart[c + 1]]
+	std::vector<int> cellStart;
+	std::vector<int> entries;
+	std::vector<int> cellOf;
+
+	// Room for maxPoints points in the biggest grid build can make with the same maxCellsPerSide,
+	// So no later build allocates however the points spread out
+	void reserve(int maxPoints, int maxCellsPerSide = 64);
+	// Cells are at least cellSize wide, but grow so there are never more than maxCellsPerSide per side
+	void build(const float* x, const float* y, int count, float cellSize, int maxCellsPerSide = 64);
+
+	int cellX(float x) const { return clampCell((int)((x - minX) / cellSize), columns); }
+	int cellY(float y) const { return clampCell((int)((y - minY) / cellSize), rows); }
+
+	// Calls f(index) for every point in the cells overlapping the square around (x, y),
+	// So the caller still has to check the actual distance
+	template<typename F>
+	void forEachCandidate(float x, float y, float range, F f) const {
+		if (columns == 0)
+			return;
+		int x0 = cellX(x - range), x1 = cellX(x + range);
+		int y0 = cellY(y - range), y1 = cellY(y + range);
+		for (int cy = y0; cy <= y1; cy++) {
+			for (int cx = x0; cx <= x1; cx++) {
+				int cell = cy * columns + cx;
+				for (int e = cellStart[cell]; e < cellStart[cell + 1]; e++)
+					f(entries[e]);
+			}
+		}
+	}
+
+	// Up to k closest points within range of (x, y), closest first, skipping the point with index exclude.
+	// x/y are the same arrays the grid was built from, returns how many were found
+	int findNearest(const float* pointsX, const float* pointsY, float x, float y, float range, int k, int* out, int exclude = -1) const;
+
+	// Upper bound for k in findNearest, it keeps its sorted distances on the stack
+	static constexpr int maxNearest = 32;
+
+private:
+	static int clampCell(int cell, int cellCount) { return cell < 0 ? 0 : (cell >= cellCount ? cellCount - 1 : cell); }
+};
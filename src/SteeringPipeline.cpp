@@ -0,0 +1,294 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "SteeringPipeline.h"
+
+static const uint32_t blendedAgent = PositionBit | VelocityBit | SteeringBit | AccelerationBit;
+
+static SteeringWeights weightsFor(Archetype& a, int row) {
+	return (a.mask & SteeringWeightsBit) ? a.steeringWeights[row] : SteeringWeights();
+}
+
+void clearAccelerationSystem(World& world) {
+	world.priorityCounters = PriorityCounters();
+	world.forEachArchetype(AccelerationBit, [](Archetype& a) {
+		for (int i = 0; i < a.size(); i++)
+			a.accelerations[i] = Acceleration();
+	});
+}
+
+// Anything below this counts as the level having nothing to say
+static const float priorityEpsilon = 0.01f;
+
+// True when a priority level above already took this agent, so the caller can skip computing its request.
+// Also counts the agents each level actually had to look at
+static bool skipAgent(World& world, const Acceleration& acceleration, SteeringPriority level) {
+	if (world.steeringComposition != PriorityComposition)
+		return false;
+	if (acceleration.resolved)
+		return true;
+	world.priorityCounters.evaluated[level]++;
+	return false;
+}
+
+// Blended adds the weighted request to the sum,
+// Priority lets the first level with a request above priorityEpsilon have the agent to itself (Turning included)
+static void submitRequest(World& world, Acceleration& acceleration, Vector2 request, float angular, SteeringPriority level) {
+	if (world.steeringComposition != PriorityComposition) {
+		acceleration.linear += request;
+		acceleration.angular += angular;
+		return;
+	}
+	if (Vector2LengthSqr(request) <= priorityEpsilon * priorityEpsilon)
+		return;
+	acceleration.linear = request;
+	acceleration.angular = angular;
+	acceleration.resolved = true;
+	world.priorityCounters.shortCircuited[level]++;
+}
+
+// Most the summed angular request can turn an agent in one tick
+static const float maxAngularAcceleration = 0.3f;
+
+// Turn towards direction with the agent's smoothness, same as the Agent behaviors do it but as a request.
+// Agents without Orientation (Or nowhere to face) don't ask to turn
+static float angularRequest(const Archetype& a, int row, Vector2 direction) {
+	if (!(a.mask & OrientationBit) || Vector2LengthSqr(direction) < 0.0001f)
+		return 0.0f;
+	const Orientation& orientation = a.orientations[row];
+	float delta = atan2f(direction.y, direction.x) - orientation.angle;
+	if (delta > PI) delta -= 2 * PI;
+	else if (delta < -PI) delta += 2 * PI;
+	return delta * orientation.rotationSmoothness;
+}
+
+// Per behavior coefficients so the kernel below doesn't branch on the behavior:
+// aim = sign * (target - position) + prediction * targetVelocity * t
+// Order matches the Behaviors enum (Seek, Flee, Pursue, Evade, Arrive, Wander)
+static const float behaviorSign[] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f };
+static const float behaviorPrediction[] = { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f };
+static const float behaviorArrive[] = { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+// Every row's random stream and this tick's wander draw, for the whole archetype in one batch
+static std::vector<uint64_t> wanderKeys;
+static std::vector<int> wanderSteps;
+
+void targetRequestSystem(World& world) {
+	world.forEachArchetype(blendedAgent, [&world](Archetype& a) {
+		const float maxPrediction = 50.0f;
+		const float arriveRadius = 200.0f;
+
+		// Wander has no real target, so it gets one here and is then treated exactly like seek
+		if (a.mask & OrientationBit) {
+			wanderKeys.resize(a.size());
+			wanderSteps.resize(a.size());
+			for (int i = 0; i < a.size(); i++)
+				wanderKeys[i] = entityRandomKey(a.entities[i]);
+			randomRanges(wanderKeys.data(), world.tick, -1, 1, wanderSteps.data(), a.size());
+
+			for (int i = 0; i < a.size(); i++) {
+				Steering& steering = a.steerings[i];
+				if (steering.behavior != Wander || (world.steeringComposition == PriorityComposition && a.accelerations[i].resolved))
+					continue;
+				float angle = a.orientations[i].angle;
+				steering.state.wanderOrientation += wanderSteps[i] * 1.0f;
+				float targetOrientation = steering.state.wanderOrientation + angle;
+				steering.targetPosition = a.positions[i].value + Vector2{ cosf(angle), sinf(angle) } * 250.0f
+					+ Vector2{ cosf(targetOrientation), sinf(targetOrientation) } * 35.0f;
+				steering.targetVelocity = Vector2{ 0, 0 };
+				steering.hasTarget = true;
+			}
+		}
+
+		for (int i = 0; i < a.size(); i++) {
+			if (skipAgent(world, a.accelerations[i], TargetPriority))
+				continue;
+			const Steering& steering = a.steerings[i];
+			int behavior = steering.behavior;
+			float sign = behaviorSign[behavior];
+			float predict = behaviorPrediction[behavior];
+			float arrive = behaviorArrive[behavior];
+
+			Vector2 offset = steering.targetPosition - a.positions[i].value;
+			float distance = sqrtf(offset.x * offset.x + offset.y * offset.y);
+
+			// Same prediction as PursueBehavior, zero inside maxPrediction, then distance / speed capped
+			float predictionTime = fminf(distance / fmaxf(steering.speed, 0.001f), maxPrediction);
+			predictionTime = distance > maxPrediction ? predictionTime : 0.0f;
+
+			Vector2 aim = offset * sign + steering.targetVelocity * (predict * predictionTime);
+			float aimLength = sqrtf(aim.x * aim.x + aim.y * aim.y);
+			Vector2 direction = aimLength > 0.001f ? aim / aimLength : Vector2{ 0, 0 };
+
+			// Arrive slows down linearly inside arriveRadius, everything else keeps full speed
+			float arriveSpeed = fminf(distance / arriveRadius, 1.0f) * steering.speed;
+			float speed = arrive * arriveSpeed + (1.0f - arrive) * steering.speed;
+
+			// Clamped before weighting so the weights compare requests of the same size
+			float weight = steering.hasTarget ? weightsFor(a, i).target : 0.0f;
+			Vector2 request = Vector2ClampValue(direction * speed - a.velocities[i].value, 0.0f, steering.maxAcceleration);
+			submitRequest(world, a.accelerations[i], request * weight, angularRequest(a, i, direction) * weight, TargetPriority);
+			if (world.steeringComposition == PriorityComposition && !a.accelerations[i].resolved)
+				world.priorityCounters.unresolved++;
+		}
+	});
+}
+
+// Flat SoA copies of every blended agent, so the pair loop is plain float arrays
+static std::vector<float> separationX;
+static std::vector<float> separationY;
+static std::vector<float> separationRadius;
+static std::vector<float> separationScale;
+static std::vector<float> separationPushX;
+static std::vector<float> separationPushY;
+static std::vector<uint8_t> separationSkip;
+
+void separationRequestSystem(World& world) {
+	separationX.clear();
+	separationY.clear();
+	separationRadius.clear();
+	separationScale.clear();
+	separationSkip.clear();
+	world.forEachArchetype(blendedAgent | ColliderBit, [&world](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			// Resolved agents still push the others, they just don't need their own sum
+			separationSkip.push_back(skipAgent(world, a.accelerations[i], SeparationPriority));
+			separationX.push_back(a.positions[i].value.x);
+			separationY.push_back(a.positions[i].value.y);
+			separationRadius.push_back(a.colliders[i].radius);
+			separationScale.push_back(a.colliders[i].separationScale);
+		}
+	});
+
+	int count = separationX.size();
+	separationPushX.assign(count, 0.0f);
+	separationPushY.assign(count, 0.0f);
+
+	// Push strength goes from 1 when touching to 0 at the minimum distance, no branches in the inner loop
+	for (int i = 0; i < count; i++) {
+		if (separationSkip[i])
+			continue;
+		float xi = separationX[i];
+		float yi = separationY[i];
+		float ri = separationRadius[i];
+		float scale = separationScale[i];
+		float pushX = 0.0f;
+		float pushY = 0.0f;
+		for (int j = 0; j < count; j++) {
+			float dx = xi - separationX[j];
+			float dy = yi - separationY[j];
+			float distSq = dx * dx + dy * dy + 0.0001f;
+			float invDist = 1.0f / sqrtf(distSq);
+			float minimumDistance = (ri + separationRadius[j]) * scale;
+			float strength = fmaxf(1.0f - distSq * invDist / minimumDistance, 0.0f);
+			strength = j == i ? 0.0f : strength;
+			pushX += dx * invDist * strength;
+			pushY += dy * invDist * strength;
+		}
+		separationPushX[i] = pushX;
+		separationPushY[i] = pushY;
+	}
+
+	int index = 0;
+	world.forEachArchetype(blendedAgent | ColliderBit, [&world, &index](Archetype& a) {
+		for (int i = 0; i < a.size(); i++, index++) {
+			if (separationSkip[index])
+				continue;
+			Vector2 push = { separationPushX[index], separationPushY[index] };
+			submitRequest(world, a.accelerations[i], push * (a.steerings[i].maxAcceleration * weightsFor(a, i).separation), 0.0f, SeparationPriority);
+		}
+	});
+}
+
+// Proper distance to each wall segment instead of the midpoint test in ObjectAvoidance::avoidWalls
+void wallRequestSystem(World& world) {
+	if (world.walls.empty())
+		return;
+
+	const std::vector<EcsWall>& walls = world.walls;
+	world.forEachArchetype(blendedAgent | ColliderBit, [&world, &walls](Archetype& a) {
+		const float margin = 50.0f;
+		for (int i = 0; i < a.size(); i++) {
+			if (skipAgent(world, a.accelerations[i], WallPriority))
+				continue;
+			Vector2 position = a.positions[i].value;
+			float range = a.colliders[i].radius + margin;
+			Vector2 push = { 0, 0 };
+
+			for (const EcsWall& wall : walls) {
+				// Cheap box reject first, most agents are nowhere near most walls
+				if (position.x < fminf(wall.start.x, wall.end.x) - range || position.x > fmaxf(wall.start.x, wall.end.x) + range ||
+					position.y < fminf(wall.start.y, wall.end.y) - range || position.y > fmaxf(wall.start.y, wall.end.y) + range)
+					continue;
+				Vector2 segment = wall.end - wall.start;
+				float lengthSq = fmaxf(Vector2LengthSqr(segment), 0.0001f);
+				float t = Clamp(Vector2DotProduct(position - wall.start, segment) / lengthSq, 0.0f, 1.0f);
+				Vector2 away = position - (wall.start + segment * t);
+				float distance = fmaxf(Vector2Length(away), 0.0001f);
+				float strength = fmaxf(1.0f - distance / range, 0.0f);
+				push += away * (strength / distance);
+			}
+
+			// Turns away from the wall as well, harder the closer it is
+			float weight = weightsFor(a, i).walls;
+			float angular = angularRequest(a, i, push) * fminf(Vector2Length(push), 1.0f);
+			submitRequest(world, a.accelerations[i], push * (a.steerings[i].maxAcceleration * weight), angular * weight, WallPriority);
+		}
+	});
+}
+
+void integrateSystem(World& world) {
+	world.forEachArchetype(blendedAgent, [](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			const Steering& steering = a.steerings[i];
+			Vector2 acceleration = Vector2ClampValue(a.accelerations[i].linear, 0.0f, steering.maxAcceleration);
+			Vector2 velocity = Vector2ClampValue(a.velocities[i].value + acceleration, 0.0f, steering.speed);
+			a.velocities[i].value = velocity;
+			a.positions[i].value += velocity;
+		}
+
+		// Facing comes from the summed angular requests, the same way velocity comes from the linear ones
+		if (!(a.mask & OrientationBit))
+			return;
+		for (int i = 0; i < a.size(); i++) {
+			Orientation& orientation = a.orientations[i];
+			orientation.angle += Clamp(a.accelerations[i].angular, -maxAngularAcceleration, maxAngularAcceleration);
+			if (orientation.angle > PI) orientation.angle -= 2 * PI;
+			else if (orientation.angle < -PI) orientation.angle += 2 * PI;
+			orientation.forward = { cosf(orientation.angle), sinf(orientation.angle) };
+		}
+	});
+}
+
+void addSteeringPasses(std::vector<System>& systems, SteeringComposition composition) {
+	systems.push_back(ClearAccelerationPhase);
+	if (composition == PriorityComposition) {
+		systems.push_back(WallRequestPhase);
+		systems.push_back(SeparationRequestPhase);
+		systems.push_back(TargetRequestPhase);
+	}
+	else {
+		systems.push_back(TargetRequestPhase);
+		systems.push_back(SeparationRequestPhase);
+		systems.push_back(WallRequestPhase);
+	}
+	systems.push_back(IntegratePhase);
+}
+
+void drawPriorityCounters(const World& world, int x, int y) {
+	if (world.steeringComposition != PriorityComposition) {
+		DrawText("Steering (B to toggle): blended", x, y, 20, RED);
+		return;
+	}
+	const PriorityCounters& c = world.priorityCounters;
+	DrawText(TextFormat("Steering (B to toggle): priority, stopped at walls %d/%d, separation %d/%d, target %d/%d, nothing %d",
+		c.shortCircuited[WallPriority], c.evaluated[WallPriority],
+		c.shortCircuited[SeparationPriority], c.evaluated[SeparationPriority],
+		c.shortCircuited[TargetPriority], c.evaluated[TargetPriority], c.unresolved), x, y, 20, RED);
+}
+
+const System ClearAccelerationPhase = { "clearAcceleration", clearAccelerationSystem, NoSystemFlags, AccelerationBit, NoSystemFlags };
+const System TargetRequestPhase = { "targetRequest", targetRequestSystem, PositionBit | VelocityBit | OrientationBit | SteeringWeightsBit, AccelerationBit | SteeringBit, NoSystemFlags };
+const System SeparationRequestPhase = { "separationRequest", separationRequestSystem, PositionBit | ColliderBit | SteeringBit | SteeringWeightsBit, AccelerationBit, NoSystemFlags };
+const System WallRequestPhase = { "wallRequest", wallRequestSystem, PositionBit | OrientationBit | ColliderBit | SteeringBit | SteeringWeightsBit | WallsResource, AccelerationBit, NoSystemFlags };
+const System IntegratePhase = { "integrate", integrateSystem, AccelerationBit | SteeringBit, PositionBit | VelocityBit | OrientationBit, NoSystemFlags };
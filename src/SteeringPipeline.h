@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// Blended steering.
+// In steeringSystem every behavior moves the agent itself, so when separation and wall avoidance both want something
+// The last one wins (What the note in ObjectAvoidance::drawWalls is about). Here every behavior is a pass over
+// All agents that only adds a weighted linear and angular acceleration request into the Acceleration column,
+// And integrateSystem is the only thing that touches velocity, position and orientation.
+// Target turns the agent towards where it's steering and walls turn it away from the wall, separation only pushes.
+// N behaviors therefore cost N flat loops over the columns rather than N virtual calls per agent.
+//
+// Agents opt in by having Acceleration (and optionally SteeringWeights, defaults are used otherwise).
+//
+// With world.steeringComposition set to PriorityComposition the same passes run walls -> separation -> target instead,
+// And the first one whose (weighted) request is above a small epsilon gets the agent to itself.
+// Lower passes skip resolved agents before doing any work, which is most agents once they are away from walls and each other.
+
+void clearAccelerationSystem(World& world);
+// Seek/Flee/Pursue/Evade/Arrive/Wander from the Steering component, as one branch free kernel
+void targetRequestSystem(World& world);
+void separationRequestSystem(World& world);
+void wallRequestSystem(World& world);
+// Clamps the summed requests (maxAcceleration for linear), then updates velocity, position and orientation
+void integrateSystem(World& world);
+
+// Appends clear, the request passes in the order the composition needs, and integrate
+void addSteeringPasses(std::vector<System>& systems, SteeringComposition composition);
+// How many agents each priority level took this frame, out of how many it looked at
+void drawPriorityCounters(const World& world, int x, int y);
+
+extern const System ClearAccelerationPhase;
+extern const System TargetRequestPhase;
+extern const System SeparationRequestPhase;
+extern const System WallRequestPhase;
+extern const System IntegratePhase;
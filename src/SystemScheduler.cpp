@@ -0,0 +1,170 @@
+#include "raylib.h"
+
+#include <chrono>
+
+#include "SystemScheduler.h"
+
+static double nowMs() {
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+SystemScheduler::SystemScheduler(ThreadPool& _pool) : pool(_pool), parallel(true) {
+	systemCount = 0;
+	frameMs = 0;
+	totalWorkMs = 0;
+	criticalPathMs = 0;
+	criticalPathLength = 0;
+	graphDepth = 0;
+	readyMask = 0;
+	doneMask = 0;
+	dispatchedMask = 0;
+	for (int i = 0; i < maxSystems; i++) {
+		systemMs[i] = 0;
+		dependencies[i] = 0;
+	}
+}
+
+bool SystemScheduler::conflicts(const System& a, const System& b) {
+	return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+}
+
+// Earlier systems in the set win, so conflicting systems keep the order the scenario listed them in
+void SystemScheduler::buildGraph(SystemSet& set) {
+	systemCount = set.systems.size() < maxSystems ? (int)set.systems.size() : maxSystems;
+	for (int j = 0; j < systemCount; j++) {
+		dependencies[j] = 0;
+		for (int i = 0; i < j; i++) {
+			if (conflicts(set.systems[i], set.systems[j]))
+				dependencies[j] |= 1u << i;
+		}
+	}
+}
+
+void SystemScheduler::run(SystemSet& set, World& world) {
+	double start = nowMs();
+	buildGraph(set);
+
+	if (parallel && pool.workerCount() > 0)
+		runParallel(set, world);
+	else
+		runSerial(set, world);
+
+	world.tick++;
+	world.timers.advance();
+	frameMs = (float)(nowMs() - start);
+	computeCriticalPath();
+}
+
+void SystemScheduler::runSystem(int index, const System& system, World& world) {
+	double start = nowMs();
+	system.run(world);
+	systemMs[index] = (float)(nowMs() - start);
+}
+
+void SystemScheduler::runSerial(SystemSet& set, World& world) {
+	for (int i = 0; i < systemCount; i++)
+		runSystem(i, set.systems[i], world);
+}
+
+void SystemScheduler::workerTask(void* data) {
+	TaskContext& context = *static_cast<TaskContext*>(data);
+	context.scheduler->runSystem(context.index, *context.system, *context.world);
+	context.scheduler->markDone(context.index);
+}
+
+void SystemScheduler::markDone(int index) {
+	std::lock_guard<std::mutex> lock(mutex);
+	doneMask |= 1u << index;
+	for (int j = 0; j < systemCount; j++) {
+		uint32_t bit = 1u << j;
+		if (!(dispatchedMask & bit) && !(readyMask & bit) && (dependencies[j] & doneMask) == dependencies[j])
+			readyMask |= bit;
+	}
+	// Notify under the lock, once the main thread sees the last system done it may leave run() straight away
+	finished.notify_one();
+}
+
+void SystemScheduler::runParallel(SystemSet& set, World& world) {
+	uint32_t allMask = systemCount == 32 ? 0xFFFFFFFFu : (1u << systemCount) - 1;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneMask = 0;
+	dispatchedMask = 0;
+	readyMask = 0;
+	for (int j = 0; j < systemCount; j++) {
+		if (dependencies[j] == 0)
+			readyMask |= 1u << j;
+	}
+
+	while (doneMask != allMask) {
+		bool ranOnMainThread = false;
+		for (int j = 0; j < systemCount; j++) {
+			uint32_t bit = 1u << j;
+			if (!(readyMask & bit))
+				continue;
+
+			readyMask &= ~bit;
+			dispatchedMask |= bit;
+			const System& system = set.systems[j];
+			if (system.flags & MainThreadOnly) {
+				// Run it right here, and then look for newly ready work again
+				lock.unlock();
+				runSystem(j, system, world);
+				markDone(j);
+				lock.lock();
+				ranOnMainThread = true;
+				break;
+			}
+
+			contexts[j] = TaskContext{ this, &system, &world, j };
+			pool.submit(ThreadTask{ workerTask, &contexts[j] });
+		}
+
+		if (!ranOnMainThread && doneMask != allMask && readyMask == 0)
+			finished.wait(lock, [this, allMask] { return readyMask != 0 || doneMask == allMask; });
+	}
+}
+
+void SystemScheduler::computeCriticalPath() {
+	float longestMs[maxSystems];
+	int longestCount[maxSystems];
+	int depth[maxSystems];
+
+	totalWorkMs = 0;
+	criticalPathMs = 0;
+	criticalPathLength = 0;
+	graphDepth = 0;
+	for (int j = 0; j < systemCount; j++) {
+		float bestMs = 0;
+		int bestCount = 0;
+		int bestDepth = 0;
+		for (int i = 0; i < j; i++) {
+			if (!(dependencies[j] & (1u << i)))
+				continue;
+			if (longestMs[i] > bestMs) {
+				bestMs = longestMs[i];
+				bestCount = longestCount[i];
+			}
+			if (depth[i] > bestDepth)
+				bestDepth = depth[i];
+		}
+		longestMs[j] = bestMs + systemMs[j];
+		longestCount[j] = bestCount + 1;
+		depth[j] = bestDepth + 1;
+		totalWorkMs += systemMs[j];
+
+		if (longestMs[j] > criticalPathMs) {
+			criticalPathMs = longestMs[j];
+			criticalPathLength = longestCount[j];
+		}
+		if (depth[j] > graphDepth)
+			graphDepth = depth[j];
+	}
+}
+
+void SystemScheduler::drawStats(int x, int y) {
+	DrawText(TextFormat("Scheduler (T to toggle): %s, %d workers", parallel ? "parallel" : "serial", pool.workerCount()), x, y, 20, RED);
+	DrawText(TextFormat("Frame %.3f ms, work %.3f ms, critical path %.3f ms over %d systems (graph depth %d/%d)",
+		frameMs, totalWorkMs, criticalPathMs, criticalPathLength, graphDepth, systemCount), x, y + 25, 20, RED);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "EcsSystems.h"
+#include "ThreadPool.h"
+
+// Runs a SystemSet as a task graph instead of one call after another.
+// Each frame the reads/writes masks of the systems are compared: a system depends on every earlier system
+// In the set it conflicts with (one writes something the other reads or writes), everything else is free to overlap.
+// Systems without conflicts go to the thread pool, MainThreadOnly ones (drawing, input) stay on the calling thread.
+struct SystemScheduler {
+	static constexpr int maxSystems = 32;
+
+	ThreadPool& pool;
+	bool parallel;
+
+	// Filled in by run(), from the frame that just finished
+	float systemMs[maxSystems];
+	uint32_t dependencies[maxSystems];
+	int systemCount;
+	float frameMs;
+	float totalWorkMs;
+	// Longest chain of dependent systems weighted by how long they took, the lower bound for the frame
+	float criticalPathMs;
+	int criticalPathLength;
+	// Longest chain counted in systems, ignoring their cost
+	int graphDepth;
+
+	SystemScheduler(ThreadPool& _pool);
+
+	void run(SystemSet& set, World& world);
+	void drawStats(int x, int y);
+
+	static bool conflicts(const System& a, const System& b);
+
+private:
+	struct TaskContext {
+		SystemScheduler* scheduler;
+		const System* system;
+		World* world;
+		int index;
+	};
+
+	TaskContext contexts[maxSystems];
+	std::mutex mutex;
+	std::condition_variable finished;
+	uint32_t readyMask;
+	uint32_t doneMask;
+	uint32_t dispatchedMask;
+
+	void buildGraph(SystemSet& set);
+	void runSerial(SystemSet& set, World& world);
+	void runParallel(SystemSet& set, World& world);
+	void runSystem(int index, const System& system, World& world);
+	void markDone(int index);
+	void computeCriticalPath();
+
+	static void workerTask(void* data);
+};
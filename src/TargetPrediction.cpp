@@ -0,0 +1,47 @@
+#include "TargetPrediction.h"
+
+void PredictionLanes::resize(int count) {
+	x.resize(count);
+	y.resize(count);
+	speed.resize(count);
+	sign.resize(count);
+	targetX.resize(count);
+	targetY.resize(count);
+	targetVelocityX.resize(count);
+	targetVelocityY.resize(count);
+	directionX.resize(count);
+	directionY.resize(count);
+}
+
+void PredictionLanes::predict(int count, PredictionMode mode) {
+	for (int i = 0; i < count; i++) {
+		float offsetX = targetX[i] - x[i];
+		float offsetY = targetY[i] - y[i];
+		float t = predictionTime(offsetX, offsetY, targetVelocityX[i], targetVelocityY[i], speed[i], mode);
+		directionX[i] = offsetX * sign[i] + targetVelocityX[i] * t;
+		directionY[i] = offsetY * sign[i] + targetVelocityY[i] * t;
+	}
+}
+
+// Room for as many objects as the scenarios spawn, so a lookup doesn't allocate after startup
+TargetPredictionCache::TargetPredictionCache() {
+	entries.reserve(128);
+}
+
+void TargetPredictionCache::nextFrame() {
+	frame++;
+}
+
+const TargetSnapshot& TargetPredictionCache::get(const Object* target) {
+	uint32_t slot = target->handle.index;
+	if (slot >= entries.size())
+		entries.resize(slot + 1, Entry{ {}, UINT32_MAX, 0 });
+
+	Entry& entry = entries[slot];
+	if (entry.frame != frame || entry.generation != target->handle.generation) {
+		entry.snapshot = TargetSnapshot{ target->position, target->GetVelocity() };
+		entry.frame = frame;
+		entry.generation = target->handle.generation;
+	}
+	return entry.snapshot;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "Player.h"
+
+// Pursue and evade as one kernel.
+// PursueBehavior and EvadeBehavior used to be copies of each other that only differed in which way toTarget pointed,
+// And each agent read the target's position and velocity on its own. Now the target is snapshotted once per frame
+// (TargetPredictionCache) and every agent runs the same few lines with a sign: 1 for pursue, -1 for evade.
+
+// Kinematic state of a target at the start of the frame
+struct TargetSnapshot {
+	Vector2 position;
+	Vector2 velocity;
+};
+
+// Inside this distance the target is aimed at directly, beyond it the prediction time is capped at this many frames
+constexpr float maxPrediction = 50.0f;
+
+enum PredictionMode {
+	// distance / speed capped at maxPrediction, what the book does. Overshoots a target moving sideways
+	HeuristicPrediction,
+	// Earliest time the agent at full speed can actually be where the target will be
+	InterceptPrediction,
+};
+
+// Global so part 1 and the ECS can flip it with a key
+inline PredictionMode& predictionMode() {
+	static PredictionMode mode = HeuristicPrediction;
+	return mode;
+}
+
+// How far ahead to aim, in frames. toTarget is target - agent (unsigned), only ternaries so it vectorizes.
+// Intercept solves |toTarget + targetVelocity * t| = speed * t, i.e.
+// (v.v - s^2) t^2 + 2 (toTarget.v) t + toTarget.toTarget = 0, and takes the earliest positive root.
+// No positive root means the target can't be caught, then it falls back to the heuristic
+inline float predictionTime(float toTargetX, float toTargetY, float velocityX, float velocityY, float speed, PredictionMode mode) {
+	float distance = sqrtf(toTargetX * toTargetX + toTargetY * toTargetY);
+	float heuristic = fminf(distance / fmaxf(speed, 0.001f), maxPrediction);
+	heuristic = distance > maxPrediction ? heuristic : 0.0f;
+
+	float a = velocityX * velocityX + velocityY * velocityY - speed * speed;
+	float b = 2.0f * (toTargetX * velocityX + toTargetY * velocityY);
+	float c = toTargetX * toTargetX + toTargetY * toTargetY;
+	float discriminant = b * b - 4.0f * a * c;
+	float root = sqrtf(fmaxf(discriminant, 0.0f));
+	// Same speed as the target makes it linear
+	bool linear = fabsf(a) < 0.0001f;
+	float safeA = linear ? 1.0f : a;
+	float t1 = (-b - root) / (2.0f * safeA);
+	float t2 = (-b + root) / (2.0f * safeA);
+	float earliest = fminf(t1, t2) > 0.0f ? fminf(t1, t2) : fmaxf(t1, t2);
+	float linearTime = b < 0.0f ? -c / b : -1.0f;
+	float intercept = linear ? linearTime : (discriminant >= 0.0f ? earliest : -1.0f);
+
+	return (mode == InterceptPrediction && intercept > 0.0f) ? intercept : heuristic;
+}
+
+// sign * (target - position) + targetVelocity * t, t from predictionTime
+inline Vector2 predictTargetDirection(Vector2 position, float speed, const TargetSnapshot& target, float sign, PredictionMode mode = predictionMode()) {
+	Vector2 offset = target.position - position;
+	float t = predictionTime(offset.x, offset.y, target.velocity.x, target.velocity.y, speed, mode);
+	return offset * sign + target.velocity * t;
+}
+
+// One lane per agent, for running the kernel over a whole crowd in a single loop
+struct PredictionLanes {
+	std::vector<float> x, y, speed, sign;
+	std::vector<float> targetX, targetY, targetVelocityX, targetVelocityY;
+	std::vector<float> directionX, directionY;
+
+	void resize(int count);
+	// Same as predictTargetDirection for every lane, written without branches so the compiler can vectorize it
+	void predict(int count, PredictionMode mode = predictionMode());
+};
+
+// Snapshots per Object, indexed by the object's handle slot. The first agent asking for a target in a frame takes
+// The snapshot, everyone after that just reads it
+struct TargetPredictionCache {
+	struct Entry {
+		TargetSnapshot snapshot;
+		uint32_t frame;
+		// A slot can be reused by a new object within the same frame
+		uint32_t generation;
+	};
+
+	uint32_t frame = 0;
+	std::vector<Entry> entries;
+
+	TargetPredictionCache();
+	// Call once at the start of every frame, invalidates every snapshot
+	void nextFrame();
+	const TargetSnapshot& get(const Object* target);
+};
+
+inline TargetPredictionCache& targetPredictions() {
+	static TargetPredictionCache cache;
+	return cache;
+}
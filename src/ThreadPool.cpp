@@ -0,0 +1,131 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int workerCount) : head(0), queued(0), stopping(false) {
+	workers.reserve(workerCount);
+	for (int i = 0; i < workerCount; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::instance() {
+	// One thread is the main thread, the rest become workers
+	static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+	return pool;
+}
+
+int ThreadPool::workerCount() const {
+	return (int)workers.size();
+}
+
+void ThreadPool::submit(ThreadTask task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (queued < queueCapacity) {
+			queue[(head + queued) % queueCapacity] = task;
+			queued++;
+			wakeUp.notify_one();
+			return;
+		}
+	}
+	task.function(task.data);
+}
+
+bool ThreadPool::popTask(ThreadTask& task) {
+	if (queued == 0)
+		return false;
+	task = queue[head];
+	head = (head + 1) % queueCapacity;
+	queued--;
+	return true;
+}
+
+bool ThreadPool::runPendingTask() {
+	ThreadTask task;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!popTask(task))
+			return false;
+	}
+	task.function(task.data);
+	return true;
+}
+
+void ThreadPool::workerLoop() {
+	while (true) {
+		ThreadTask task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+			if (stopping && queued == 0)
+				return;
+			popTask(task);
+		}
+		task.function(task.data);
+	}
+}
+
+// Lives on the stack of the parallelFor caller, which doesn't return before every helper has left it
+struct ParallelForJob {
+	void (*function)(void* data, int begin, int end);
+	void* data;
+	int count;
+	int chunkSize;
+	std::atomic<int> nextChunk;
+	std::atomic<int> activeHelpers;
+};
+
+static void runChunks(ParallelForJob& job) {
+	while (true) {
+		int begin = job.nextChunk.fetch_add(1) * job.chunkSize;
+		if (begin >= job.count)
+			return;
+		int end = begin + job.chunkSize < job.count ? begin + job.chunkSize : job.count;
+		job.function(job.data, begin, end);
+	}
+}
+
+static void parallelForHelper(void* data) {
+	ParallelForJob& job = *static_cast<ParallelForJob*>(data);
+	runChunks(job);
+	job.activeHelpers.fetch_sub(1);
+}
+
+void ThreadPool::parallelFor(int count, int chunkSize, void (*function)(void* data, int begin, int end), void* data) {
+	if (count <= 0)
+		return;
+	if (chunkSize < 1)
+		chunkSize = 1;
+
+	int chunks = (count + chunkSize - 1) / chunkSize;
+	int helpers = chunks - 1 < workerCount() ? chunks - 1 : workerCount();
+	if (helpers <= 0) {
+		function(data, 0, count);
+		return;
+	}
+
+	ParallelForJob job;
+	job.function = function;
+	job.data = data;
+	job.count = count;
+	job.chunkSize = chunkSize;
+	job.nextChunk.store(0);
+	job.activeHelpers.store(helpers);
+	for (int i = 0; i < helpers; i++)
+		submit(ThreadTask{ parallelForHelper, &job });
+
+	runChunks(job);
+	// Helpers might still be queued behind other work, run queued tasks ourselves rather than just spin
+	while (job.activeHelpers.load() > 0) {
+		if (!runPendingTask())
+			std::this_thread::yield();
+	}
+}
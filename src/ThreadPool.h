@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Plain function + pointer instead of std::function so submitting a task never allocates
+struct ThreadTask {
+	void (*function)(void* data);
+	void* data;
+};
+
+// Fixed set of worker threads pulling tasks off a ring buffer.
+// Used by the system scheduler to run independent phases at the same time,
+// And by systems themselves through parallelFor to split a loop over agents.
+struct ThreadPool {
+	static constexpr int queueCapacity = 256;
+
+	ThreadPool(int workerCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Runs the task on the calling thread if the queue is full
+	void submit(ThreadTask task);
+	// Pops one queued task and runs it on the calling thread, so a thread that waits can help out instead
+	bool runPendingTask();
+	int workerCount() const;
+
+	// Calls function(data, begin, end) over [0, count) in chunks, on the workers and the calling thread.
+	// Blocks until every chunk is done. Safe to call from inside a task.
+	void parallelFor(int count, int chunkSize, void (*function)(void* data, int begin, int end), void* data);
+
+	// Shared pool sized to the machine, created on first use
+	static ThreadPool& instance();
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	ThreadTask queue[queueCapacity];
+	int head;
+	int queued;
+	bool stopping;
+
+	void workerLoop();
+	bool popTask(ThreadTask& task);
+};
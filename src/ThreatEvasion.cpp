@@ -0,0 +1,82 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "ThreatEvasion.h"
+#include "SpatialGrid.h"
+#include "TargetPrediction.h"
+
+// Flat copy of every threat, the grid indexes into these
+static std::vector<float> threatX;
+static std::vector<float> threatY;
+static std::vector<Vector2> threatVelocity;
+static std::vector<float> threatWeight;
+static SpatialGrid threatGrid;
+
+void reserveThreatEvasion(int maxThreats) {
+	threatX.reserve(maxThreats);
+	threatY.reserve(maxThreats);
+	threatVelocity.reserve(maxThreats);
+	threatWeight.reserve(maxThreats);
+	threatGrid.reserve(maxThreats);
+}
+
+void threatEvasionSystem(World& world) {
+	threatX.clear();
+	threatY.clear();
+	threatVelocity.clear();
+	threatWeight.clear();
+	world.forEachArchetype(PositionBit | ThreatBit, [](Archetype& a) {
+		bool moving = a.mask & VelocityBit;
+		for (int i = 0; i < a.size(); i++) {
+			threatX.push_back(a.positions[i].value.x);
+			threatY.push_back(a.positions[i].value.y);
+			threatVelocity.push_back(moving ? a.velocities[i].value : Vector2{ 0, 0 });
+			threatWeight.push_back(a.threats[i].weight);
+		}
+	});
+
+	float cellSize = 1.0f;
+	world.forEachArchetype(EvasionBit, [&cellSize](Archetype& a) {
+		for (int i = 0; i < a.size(); i++)
+			cellSize = fmaxf(cellSize, a.evasions[i].radius);
+	});
+	threatGrid.build(threatX.data(), threatY.data(), threatX.size(), cellSize);
+
+	world.forEachArchetype(PositionBit | SteeringBit | EvasionBit, [](Archetype& a) {
+		int nearest[SpatialGrid::maxNearest];
+		PredictionMode mode = predictionMode();
+
+		for (int i = 0; i < a.size(); i++) {
+			Vector2 position = a.positions[i].value;
+			Steering& steering = a.steerings[i];
+			Evasion& evasion = a.evasions[i];
+
+			int count = threatGrid.findNearest(threatX.data(), threatY.data(), position.x, position.y, evasion.radius, evasion.maxThreats, nearest);
+			evasion.threatCount = count;
+			steering.hasTarget = false;
+			if (count == 0)
+				continue;
+
+			// Weighted by weight / distance, so something twice as close counts twice as much
+			Vector2 weightedSum = { 0, 0 };
+			float totalWeight = 0.0f;
+			for (int n = 0; n < count; n++) {
+				int t = nearest[n];
+				Vector2 offset = Vector2{ threatX[t], threatY[t] } - position;
+				float time = predictionTime(offset.x, offset.y, threatVelocity[t].x, threatVelocity[t].y, steering.speed, mode);
+				Vector2 predicted = Vector2{ threatX[t], threatY[t] } + threatVelocity[t] * time;
+
+				float weight = threatWeight[t] / fmaxf(Vector2Length(offset), 1.0f);
+				weightedSum += predicted * weight;
+				totalWeight += weight;
+			}
+
+			// Prediction is already baked in, so steering shouldn't predict again
+			steering.targetPosition = weightedSum / fmaxf(totalWeight, 0.0001f);
+			steering.targetVelocity = Vector2{ 0, 0 };
+			steering.hasTarget = true;
+		}
+	});
+}
+
+const System ThreatEvasionPhase = { "threatEvasion", threatEvasionSystem, PositionBit | VelocityBit | ThreatBit, SteeringBit | EvasionBit, NoSystemFlags };
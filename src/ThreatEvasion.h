@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// Evade against many pursuers at once.
+// EvadeBehavior only ever looks at the one Object* it's given. Here every entity with Evasion looks up the threats
+// Around it in a uniform grid (SpatialGrid.h), keeps the closest maxThreats, predicts where each will be
+// (Same prediction as evade, TargetPrediction.h) and flees from the inverse distance weighted average of those.
+// Close threats dominate, and the cost per evader is bounded by maxThreats rather than the number of threats.
+//
+// It only writes the Steering target, so the evader should use Flee and steeringSystem does the moving.
+void threatEvasionSystem(World& world);
+// Scratch space and grid for up to maxThreats threats, call it when a scenario sets them up so the system never grows it
+void reserveThreatEvasion(int maxThreats);
+
+extern const System ThreatEvasionPhase;
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cmath>
+
+#include "raylib.h"
+
+#include "TimeSlicer.h"
+
+static double nowMs() {
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+void TimeSlice::run(uint32_t tick, int _count, int batchSize, void (*service)(void* data, int begin, int end), void* data) {
+	double start = nowMs();
+	// Agents that just showed up count as serviced now, otherwise they'd start out starved since tick 0
+	if ((int)lastServiced.size() != _count)
+		lastServiced.resize(_count, tick);
+	count = _count;
+	serviced = 0;
+	if (cursor >= count)
+		cursor = 0;
+	if (batchSize < 1)
+		batchSize = 1;
+
+	float available = budgetMs - debtMs;
+	while (serviced < count) {
+		int begin = cursor;
+		int end = begin + batchSize;
+		if (end > count)
+			end = count;
+		// Don't come round to the agents this tick already started with
+		if (end - begin > count - serviced)
+			end = begin + count - serviced;
+
+		service(data, begin, end);
+		for (int i = begin; i < end; i++)
+			lastServiced[i] = tick;
+		serviced += end - begin;
+
+		cursor = end == count ? 0 : end;
+		if (cursor == 0) {
+			roundTicks = tick - lastWrap;
+			lastWrap = tick;
+		}
+		if (budgetMs > 0.0f && nowMs() - start >= available)
+			break;
+	}
+
+	usedMs = (float)(nowMs() - start);
+	// Capped at one budget, so one slow tick doesn't stall the agents for several ticks afterwards
+	debtMs = budgetMs > 0.0f ? fminf(fmaxf(usedMs - available, 0.0f), budgetMs) : 0.0f;
+
+	maxStarvation = 0;
+	uint64_t totalStarvation = 0;
+	for (int i = 0; i < count; i++) {
+		uint32_t starvation = tick - lastServiced[i];
+		maxStarvation = starvation > maxStarvation ? starvation : maxStarvation;
+		totalStarvation += starvation;
+	}
+	averageStarvation = count > 0 ? (float)totalStarvation / count : 0.0f;
+}
+
+void TimeSlice::clear() {
+	budgetMs = 0.0f;
+	cursor = 0;
+	debtMs = 0.0f;
+	lastServiced.clear();
+	serviced = 0;
+	count = 0;
+	usedMs = 0.0f;
+	maxStarvation = 0;
+	averageStarvation = 0.0f;
+	roundTicks = 0;
+	lastWrap = 0;
+}
+
+void TimeSlice::drawStats(const char* name, int x, int y) const {
+	DrawText(TextFormat("%s, %.2f ms budget (K to change): %d/%d agents in %.3f ms, full pass every %u ticks, starved up to %u ticks (%.1f average)",
+		name, budgetMs, serviced, count, usedMs, roundTicks, maxStarvation, averageStarvation), x, y, 20, RED);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Time budget for per agent AI work that doesn't have to happen for every agent every tick (Deciding on a behavior).
+// Each tick a slice carries on from where the last one stopped and services agents in batches until its
+// Millisecond budget is used up, so the agents nobody got to are simply first in line next tick (Round robin).
+// The clock is only read between batches, so a batch that runs over the budget is paid back on the next tick.
+//
+// Agents are numbered 0..count over all the archetypes a system looks at (See forEachRowRange in EcsSystems.h).
+// When entities are destroyed the numbers after them shift down, which only muddles the starvation numbers a bit.
+enum AiSubsystem {
+	BehaviorTreeSubsystem,
+	UtilityAISubsystem,
+	AiSubsystemCount,
+};
+
+struct TimeSlice {
+	// 0 means no budget, every agent is serviced every tick
+	float budgetMs = 0.0f;
+	// First agent of the next tick
+	int cursor = 0;
+	// How far the last tick went over its budget, taken off the next one
+	float debtMs = 0.0f;
+	// Tick each agent was last serviced on
+	std::vector<uint32_t> lastServiced;
+
+	// From the last tick, for the overlay
+	int serviced = 0;
+	int count = 0;
+	float usedMs = 0.0f;
+	// Most ticks any agent has gone without being serviced, and the average over all of them
+	uint32_t maxStarvation = 0;
+	float averageStarvation = 0.0f;
+	// Ticks the last complete pass over every agent took
+	uint32_t roundTicks = 0;
+	uint32_t lastWrap = 0;
+
+	// Calls service(data, begin, end) over batches of at most batchSize agents, starting at cursor and wrapping around,
+	// Until the budget is gone or every agent has had its turn this tick. At least one batch always runs so nobody starves forever
+	void run(uint32_t tick, int count, int batchSize, void (*service)(void* data, int begin, int end), void* data);
+	void clear();
+	void drawStats(const char* name, int x, int y) const;
+};
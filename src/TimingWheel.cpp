@@ -0,0 +1,138 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel() {
+	for (int32_t& head : heads)
+		head = -1;
+}
+
+void TimingWheel::reserve(int count) {
+	timers.reserve(count);
+}
+
+static void setFlag(void* data, uint64_t) {
+	*static_cast<uint8_t*>(data) = 1;
+}
+
+TimerHandle TimingWheel::schedule(uint32_t delay, TimerCallback callback, void* data, uint64_t payload) {
+	int32_t index = firstFree;
+	if (index != -1)
+		firstFree = timers[index].next;
+	else {
+		index = timers.size();
+		timers.push_back(Timer{});
+	}
+
+	Timer& timer = timers[index];
+	// The earliest a timer can fire is the next advance
+	timer.expires = now + (delay > 0 ? delay : 1);
+	timer.callback = callback;
+	timer.data = data;
+	timer.payload = payload;
+	link(index);
+	pendingCount++;
+	return TimerHandle{ (uint32_t)index, timer.generation };
+}
+
+TimerHandle TimingWheel::scheduleFlag(uint32_t delay, uint8_t* flag) {
+	return schedule(delay, setFlag, flag);
+}
+
+bool TimingWheel::isPending(TimerHandle handle) const {
+	return handle.index < timers.size() && timers[handle.index].generation == handle.generation && timers[handle.index].slot != -1;
+}
+
+bool TimingWheel::cancel(TimerHandle handle) {
+	if (!isPending(handle))
+		return false;
+	unlink(handle.index);
+	release(handle.index);
+	return true;
+}
+
+// The wheel is picked by the highest 8 bit digit where expires and now differ, so the slot in that wheel
+// Comes up before any finer digit matters. Timers that share now's upper 24 bits go straight into the first wheel
+void TimingWheel::link(int32_t index) {
+	Timer& timer = timers[index];
+	int wheel = 0;
+	while (wheel < wheelCount - 1 && (timer.expires >> (slotBits * (wheel + 1))) != (now >> (slotBits * (wheel + 1))))
+		wheel++;
+	int32_t slot = wheel * slotCount + ((timer.expires >> (slotBits * wheel)) & (slotCount - 1));
+
+	timer.slot = slot;
+	timer.previous = -1;
+	timer.next = heads[slot];
+	if (heads[slot] != -1)
+		timers[heads[slot]].previous = index;
+	heads[slot] = index;
+}
+
+void TimingWheel::unlink(int32_t index) {
+	Timer& timer = timers[index];
+	if (timer.previous != -1)
+		timers[timer.previous].next = timer.next;
+	else
+		heads[timer.slot] = timer.next;
+	if (timer.next != -1)
+		timers[timer.next].previous = timer.previous;
+	timer.slot = -1;
+}
+
+// The generation bump is what makes old handles stop being pending
+void TimingWheel::release(int32_t index) {
+	Timer& timer = timers[index];
+	timer.generation++;
+	timer.slot = -1;
+	timer.next = firstFree;
+	firstFree = index;
+	pendingCount--;
+}
+
+void TimingWheel::advance() {
+	now++;
+	fired = 0;
+	cascaded = 0;
+
+	// Coarsest first, so a timer coming down from the last wheel can go on down in the same tick
+	for (int wheel = wheelCount - 1; wheel > 0; wheel--) {
+		uint32_t below = (1u << (slotBits * wheel)) - 1;
+		if ((now & below) != 0)
+			continue;
+		int32_t slot = wheel * slotCount + ((now >> (slotBits * wheel)) & (slotCount - 1));
+		int32_t index = heads[slot];
+		heads[slot] = -1;
+		while (index != -1) {
+			int32_t next = timers[index].next;
+			link(index);
+			cascaded++;
+			index = next;
+		}
+	}
+
+	// Taken off one at a time rather than the whole list at once, so a callback can cancel one that's still to come
+	int32_t* head = &heads[now & (slotCount - 1)];
+	while (*head != -1) {
+		int32_t index = *head;
+		Timer timer = timers[index];
+		unlink(index);
+		release(index);
+		timer.callback(timer.data, timer.payload);
+		fired++;
+	}
+}
+
+void TimingWheel::clear() {
+	firstFree = -1;
+	for (int32_t index = (int32_t)timers.size() - 1; index >= 0; index--) {
+		Timer& timer = timers[index];
+		if (timer.slot != -1)
+			timer.generation++;
+		timer.slot = -1;
+		timer.next = firstFree;
+		firstFree = index;
+	}
+	for (int32_t& head : heads)
+		head = -1;
+	pendingCount = 0;
+	fired = 0;
+	cascaded = 0;
+}
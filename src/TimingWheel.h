@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel for per agent timers and cooldowns, so nothing has to count down every agent every tick.
+// Four wheels of 256 slots: the first has a slot per tick for the next 256 ticks, the second a slot per 256 ticks,
+// And so on, which covers the whole 32 bit tick range. A timer goes into the coarsest wheel it needs, and when
+// A coarse slot comes up its timers are cascaded down into the finer wheel, until they land in the first one and fire.
+// Each timer is cascaded at most three times, so advancing costs O(1) per timer on top of the ones that fire,
+// However many are pending.
+//
+// Timers live in one pool with a free list and every slot is an intrusive doubly linked list through the pool,
+// So schedule and cancel are O(1) and nothing allocates once the pool has grown (See reserve).
+// Handles are generational like EntityHandle, cancelling a timer that already fired does nothing.
+
+typedef void (*TimerCallback)(void* data, uint64_t payload);
+
+struct TimerHandle {
+	uint32_t index;
+	uint32_t generation;
+
+	static TimerHandle invalid() {
+		return TimerHandle{ UINT32_MAX, 0 };
+	}
+
+	bool isNull() const {
+		return index == UINT32_MAX;
+	}
+};
+
+struct TimingWheel {
+	static constexpr int wheelCount = 4;
+	static constexpr int slotBits = 8;
+	static constexpr int slotCount = 1 << slotBits;
+
+	struct Timer {
+		uint32_t expires;
+		uint32_t generation;
+		// Next/previous timer in the same slot, or the next free timer. -1 ends the list
+		int32_t next;
+		int32_t previous;
+		TimerCallback callback;
+		void* data;
+		uint64_t payload;
+		// Slot it's linked into (wheel * slotCount + slot), -1 while it's free or firing
+		int32_t slot;
+	};
+
+	std::vector<Timer> timers;
+	int32_t heads[wheelCount * slotCount];
+	int32_t firstFree = -1;
+	uint32_t now = 0;
+	int pendingCount = 0;
+
+	// From the last advance, for the overlays
+	int fired = 0;
+	int cascaded = 0;
+
+	TimingWheel();
+
+	void reserve(int count);
+	// Calls callback(data, payload) delay ticks from now. A delay of 0 fires on the next advance as well
+	TimerHandle schedule(uint32_t delay, TimerCallback callback, void* data, uint64_t payload = 0);
+	// Sets *flag to 1 when it fires. The flag has to stay where it is until then, so not inside an archetype column
+	TimerHandle scheduleFlag(uint32_t delay, uint8_t* flag);
+	// Returns false if it had already fired or been cancelled
+	bool cancel(TimerHandle handle);
+	bool isPending(TimerHandle handle) const;
+	// One tick: cascades whatever coarse slots come up and fires everything that's due.
+	// Callbacks may schedule and cancel timers, including cancelling ones that would have fired this same tick
+	void advance();
+	// Drops every timer without firing it, handles to them stop being pending
+	void clear();
+	int pending() const { return pendingCount; }
+
+private:
+	void link(int32_t index);
+	void unlink(int32_t index);
+	void release(int32_t index);
+};
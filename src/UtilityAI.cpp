@@ -0,0 +1,117 @@
+#include <cmath>
+
+#include "UtilityAI.h"
+
+float ResponseCurve::evaluate(float x) const {
+	float y = 1.0f;
+	if (type == PolynomialCurve)
+		y = exponent == 1.0f ? slope * (x - shift) + offset : slope * powf(fabsf(x - shift), exponent) + offset;
+	else if (type == LogisticCurve)
+		y = 1.0f / (1.0f + expf(-slope * (x - shift))) + offset;
+	return fminf(fmaxf(y, 0.0f), 1.0f);
+}
+
+void ResponseCurve::multiplyInto(const float* x, float* out, int count) const {
+	switch (type) {
+	case PolynomialCurve:
+		// Linear is common enough to skip the pow
+		if (exponent == 1.0f) {
+			for (int i = 0; i < count; i++)
+				out[i] *= fminf(fmaxf(slope * (x[i] - shift) + offset, 0.0f), 1.0f);
+		}
+		else {
+			for (int i = 0; i < count; i++)
+				out[i] *= fminf(fmaxf(slope * powf(fabsf(x[i] - shift), exponent) + offset, 0.0f), 1.0f);
+		}
+		break;
+	case LogisticCurve:
+		for (int i = 0; i < count; i++)
+			out[i] *= fminf(fmaxf(1.0f / (1.0f + expf(-slope * (x[i] - shift))) + offset, 0.0f), 1.0f);
+		break;
+	default:
+		break;
+	}
+}
+
+static ResponseCurve linear(float slope, float offset) {
+	return ResponseCurve{ PolynomialCurve, slope, 1.0f, 0.0f, offset };
+}
+
+static ResponseCurve logistic(float slope, float shift) {
+	return ResponseCurve{ LogisticCurve, slope, 1.0f, shift, 0.0f };
+}
+
+// Roughly: far away seek, mid range pursue a moving target or arrive at a still one,
+// Too close flee (evade if it's fast), and wander when walls or the crowd get in the way
+const UtilityProfile& defaultUtilityProfile() {
+	static const UtilityProfile profile = [] {
+		UtilityProfile p;
+		p.set(Seek, DistanceInput, logistic(12.0f, 0.6f));
+		p.set(Seek, CrowdDensityInput, linear(-0.6f, 1.0f));
+
+		// Bell around 180 pixels
+		p.set(Pursue, DistanceInput, ResponseCurve{ PolynomialCurve, -12.0f, 2.0f, 0.3f, 1.0f });
+		p.set(Pursue, TargetSpeedInput, logistic(10.0f, 0.3f));
+
+		p.set(Arrive, DistanceInput, linear(-1.2f, 1.0f));
+		p.set(Arrive, TargetSpeedInput, linear(-1.0f, 1.0f));
+
+		p.set(Flee, DistanceInput, logistic(-30.0f, 0.12f));
+		p.set(Flee, TargetSpeedInput, linear(-1.0f, 1.0f));
+
+		p.set(Evade, DistanceInput, logistic(-20.0f, 0.2f));
+		p.set(Evade, TargetSpeedInput, logistic(10.0f, 0.5f));
+
+		p.set(Wander, WallProximityInput, linear(0.8f, 0.1f));
+		p.set(Wander, CrowdDensityInput, linear(0.5f, 0.0f));
+		return p;
+	}();
+	return profile;
+}
+
+void UtilityLanes::resize(int _count) {
+	count = _count;
+	for (int i = 0; i < UtilityInputCount; i++)
+		inputs[i].resize(count);
+	for (int b = 0; b < utilityBehaviorCount; b++)
+		scores[b].resize(count);
+	current.resize(count);
+	best.resize(count);
+}
+
+void UtilityLanes::reserve(int capacity) {
+	for (int i = 0; i < UtilityInputCount; i++)
+		inputs[i].reserve(capacity);
+	for (int b = 0; b < utilityBehaviorCount; b++)
+		scores[b].reserve(capacity);
+	current.reserve(capacity);
+	best.reserve(capacity);
+}
+
+void UtilityLanes::score(const UtilityProfile& profile) {
+	for (int b = 0; b < utilityBehaviorCount; b++) {
+		float* out = scores[b].data();
+		for (int i = 0; i < count; i++)
+			out[i] = 1.0f;
+		for (int input = 0; input < UtilityInputCount; input++)
+			profile.curves[b][input].multiplyInto(inputs[input].data(), out, count);
+
+		// Inertia as a multiply by 1 or 1 + inertia instead of a branch
+		const uint8_t* currentBehavior = current.data();
+		for (int i = 0; i < count; i++)
+			out[i] *= 1.0f + profile.inertia * (float)(currentBehavior[i] == b);
+	}
+
+	// Running argmax, one behavior at a time over all agents. Seek's scores turn into the best score so far
+	std::vector<float>& bestScore = scores[0];
+	for (int i = 0; i < count; i++)
+		best[i] = 0;
+	for (int b = 1; b < utilityBehaviorCount; b++) {
+		const float* candidate = scores[b].data();
+		for (int i = 0; i < count; i++) {
+			bool better = candidate[i] > bestScore[i];
+			best[i] = better ? (uint8_t)b : best[i];
+			bestScore[i] = better ? candidate[i] : bestScore[i];
+		}
+	}
+}
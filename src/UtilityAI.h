@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Agent.h"
+
+// Utility AI, the other way of picking a behavior without keys (Next to BehaviorTree.h).
+// Every candidate behavior gets a score from 0 to 1 per input through a response curve, the scores are multiplied
+// And the highest total wins. Inputs are normalised to 0..1 before they get here.
+//
+// Scoring is done in lanes: one float array per input and per behavior over all agents being evaluated,
+// Then for each (behavior, input) pair one curve is run over the whole input array. The curve type is the same
+// For every agent in that loop, so the inner loops have no branches and the compiler vectorises them (Like randomRanges).
+
+enum UtilityInput {
+	// Distance to the target, 1 is maxDistance or further
+	DistanceInput,
+	// Target speed, 1 is maxTargetSpeed or faster
+	TargetSpeedInput,
+	// 1 touching a wall, 0 wallRange or further away
+	WallProximityInput,
+	// Neighbours within crowdRange, 1 is crowdCapacity or more
+	CrowdDensityInput,
+	UtilityInputCount,
+};
+
+constexpr int utilityBehaviorCount = Wander + 1;
+
+enum CurveType : uint8_t {
+	// Always 1, so the input doesn't matter for this behavior
+	ConstantCurve,
+	// slope * |x - shift|^exponent + offset, except exponent 1 keeps the sign so it's a plain line
+	PolynomialCurve,
+	// 1 / (1 + e^(-slope * (x - shift))) + offset
+	LogisticCurve,
+};
+
+struct ResponseCurve {
+	CurveType type = ConstantCurve;
+	float slope = 1.0f;
+	float exponent = 1.0f;
+	float shift = 0.0f;
+	float offset = 0.0f;
+
+	// Scalar version, clamped to 0..1
+	float evaluate(float x) const;
+	// Over count inputs, out is multiplied by the result so the considerations of a behavior chain up
+	void multiplyInto(const float* x, float* out, int count) const;
+};
+
+struct UtilityProfile {
+	ResponseCurve curves[utilityBehaviorCount][UtilityInputCount];
+	// The current behavior's score gets multiplied by 1 + inertia, so close calls don't flip back and forth
+	float inertia = 0.15f;
+
+	void set(Behaviors behavior, UtilityInput input, ResponseCurve curve) { curves[behavior][input] = curve; }
+};
+
+// The default profile the ECS scenario uses
+const UtilityProfile& defaultUtilityProfile();
+
+// Structure of arrays for a batch of agents
+struct UtilityLanes {
+	std::vector<float> inputs[UtilityInputCount];
+	std::vector<float> scores[utilityBehaviorCount];
+	std::vector<uint8_t> current;
+	std::vector<uint8_t> best;
+	int count = 0;
+
+	void resize(int count);
+	// So resizing up to count later doesn't allocate
+	void reserve(int count);
+	// Fills best from inputs and current
+	void score(const UtilityProfile& profile);
+};
@@ -0,0 +1,173 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include "UtilityAISystem.h"
+#include "SpatialGrid.h"
+#include "UtilityAI.h"
+
+// What counts as 1 for each input
+static const float maxDistance = 600.0f;
+static const float maxTargetSpeed = 6.0f;
+static const float wallRange = 150.0f;
+static const float crowdRange = 60.0f;
+static const float crowdCapacity = 6.0f;
+
+static UtilityLanes utilityLanes;
+static std::vector<int> dueRows;
+// Agents whose timer fired since the last tick, pushed by World::timers in between frames
+static std::vector<EntityHandle> dueAgents;
+static std::vector<EntityLocation> dueLocations;
+static std::vector<float> crowdX;
+static std::vector<float> crowdY;
+static SpatialGrid crowdGrid;
+
+// From the last tick, for the overlay
+static int agentsScored = 0;
+static int agentsTotal = 0;
+static int behaviorsSwitched = 0;
+
+static float wallProximity(Vector2 position, const std::vector<EcsWall>& walls) {
+	float closest = wallRange;
+	for (const EcsWall& wall : walls) {
+		Vector2 along = wall.end - wall.start;
+		float t = Clamp(Vector2DotProduct(position - wall.start, along) / fmaxf(Vector2LengthSqr(along), 0.0001f), 0.0f, 1.0f);
+		closest = fminf(closest, Vector2Distance(position, wall.start + along * t));
+	}
+	return 1.0f - closest / wallRange;
+}
+
+static float crowdDensity(Vector2 position) {
+	float rangeSq = crowdRange * crowdRange;
+	int neighbours = 0;
+	crowdGrid.forEachCandidate(position.x, position.y, crowdRange, [&](int other) {
+		float dx = crowdX[other] - position.x;
+		float dy = crowdY[other] - position.y;
+		neighbours += dx * dx + dy * dy < rangeSq;
+	});
+	// It found itself too
+	return fminf((neighbours - 1) / crowdCapacity, 1.0f);
+}
+
+static void utilityTimerFired(void*, uint64_t payload) {
+	dueAgents.push_back(EntityHandle{ (uint32_t)payload, (uint32_t)(payload >> 32) });
+}
+
+void startUtilityTimer(World& world, EntityHandle agent, uint32_t delay) {
+	world.timers.schedule(delay, utilityTimerFired, nullptr, ((uint64_t)agent.generation << 32) | agent.index);
+}
+
+// Gathers the inputs of dueRows into the lanes, scores them in one batch and switches the ones that changed their mind
+static void scoreDueRows(World& world, Archetype& a) {
+	int count = dueRows.size();
+	utilityLanes.resize(count);
+	for (int n = 0; n < count; n++) {
+		int row = dueRows[n];
+		Vector2 position = a.positions[row].value;
+		const Steering& steering = a.steerings[row];
+		float distance = steering.hasTarget ? Vector2Distance(position, steering.targetPosition) : maxDistance;
+		utilityLanes.inputs[DistanceInput][n] = fminf(distance / maxDistance, 1.0f);
+		utilityLanes.inputs[TargetSpeedInput][n] = fminf(Vector2Length(steering.targetVelocity) / maxTargetSpeed, 1.0f);
+		utilityLanes.inputs[WallProximityInput][n] = wallProximity(position, world.walls);
+		utilityLanes.inputs[CrowdDensityInput][n] = crowdDensity(position);
+		utilityLanes.current[n] = steering.behavior;
+	}
+	utilityLanes.score(defaultUtilityProfile());
+
+	for (int n = 0; n < count; n++) {
+		Steering& steering = a.steerings[dueRows[n]];
+		Behaviors best = (Behaviors)utilityLanes.best[n];
+		if (best == steering.behavior)
+			continue;
+		steering.behavior = best;
+		steering.state = AgentBehaviorState();
+		behaviorsSwitched++;
+	}
+	agentsScored += count;
+}
+
+// One batch of the time slice
+static void serviceAgents(void* data, int begin, int end) {
+	World& world = *(World*)data;
+	forEachRowRange(world, PositionBit | SteeringBit | UtilityBit, begin, end, [&world](Archetype& a, int from, int to) {
+		bool sleeps = a.has(SleepBit);
+		dueRows.clear();
+		for (int i = from; i < to; i++) {
+			if (!sleeps || !a.sleeps[i].asleep)
+				dueRows.push_back(i);
+		}
+		scoreDueRows(world, a);
+	});
+}
+
+void utilityAISystem(World& world) {
+	agentsScored = 0;
+	agentsTotal = 0;
+	behaviorsSwitched = 0;
+
+	// Room for everyone once, the grid's cell count follows how spread out the crowd is
+	int crowdTotal = 0;
+	world.forEachArchetype(PositionBit | SteeringBit, [&crowdTotal](Archetype& a) {
+		crowdTotal += a.size();
+	});
+	crowdX.clear();
+	crowdY.clear();
+	crowdX.reserve(crowdTotal);
+	crowdY.reserve(crowdTotal);
+	crowdGrid.reserve(crowdTotal);
+	world.forEachArchetype(PositionBit | SteeringBit, [](Archetype& a) {
+		for (int i = 0; i < a.size(); i++) {
+			crowdX.push_back(a.positions[i].value.x);
+			crowdY.push_back(a.positions[i].value.y);
+		}
+	});
+	crowdGrid.build(crowdX.data(), crowdY.data(), crowdX.size(), crowdRange);
+
+	world.forEachArchetype(PositionBit | SteeringBit | UtilityBit, [](Archetype& a) {
+		agentsTotal += a.size();
+	});
+	// How many are due changes every tick (Sleeping agents drop out), so make room for all of them once
+	dueRows.reserve(agentsTotal);
+	dueAgents.reserve(agentsTotal);
+	dueLocations.reserve(agentsTotal);
+	utilityLanes.reserve(agentsTotal);
+
+	// Every agent whose timer fired gets its next one straight away, whether it's scored now or not.
+	// Destroyed agents don't resolve anymore, so their timers just stop here
+	TimeSlice& slice = world.aiSlices[UtilityAISubsystem];
+	dueLocations.clear();
+	for (EntityHandle agent : dueAgents) {
+		const EntityLocation* location = world.locations.get(agent);
+		if (!location)
+			continue;
+		Archetype& a = world.archetypes[location->archetype];
+		if (!a.has(PositionBit | SteeringBit | UtilityBit))
+			continue;
+		startUtilityTimer(world, agent, a.utilities[location->row].interval);
+		if (!(a.has(SleepBit) && a.sleeps[location->row].asleep))
+			dueLocations.push_back(*location);
+	}
+	dueAgents.clear();
+
+	// With a budget the time slice decides who gets scored and the timers only keep ticking over
+	if (slice.budgetMs > 0.0f) {
+		slice.run(world.tick, agentsTotal, 64, serviceAgents, &world);
+		return;
+	}
+
+	for (int archetype = 0; archetype < world.archetypes.size(); archetype++) {
+		dueRows.clear();
+		for (const EntityLocation& location : dueLocations) {
+			if (location.archetype == archetype)
+				dueRows.push_back(location.row);
+		}
+		if (!dueRows.empty())
+			scoreDueRows(world, world.archetypes[archetype]);
+	}
+}
+
+void drawUtilityAIStats(int x, int y) {
+	DrawText(TextFormat("Utility AI (U for behavior trees): %d/%d agents scored this tick, %d switched behavior",
+		agentsScored, agentsTotal, behaviorsSwitched), x, y, 20, RED);
+}
+
+const System UtilityAIPhase = { "utilityAI", utilityAISystem, PositionBit | SleepBit | WallsResource, SteeringBit | UtilityBit | TimersResource, NoSystemFlags };
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Ecs.h"
+#include "EcsSystems.h"
+
+// Picks Steering::behavior for UtilityAgents with the scorer in UtilityAI.h.
+// An agent is only scored every interval ticks, when its timer on World::timers fires. The first delays are
+// Staggered so each tick scores a slice of them, and nothing is counted down for the agents that aren't due.
+// The ones due this tick get their inputs gathered into lanes and scored in one batch.
+// With a budget on World::aiSlices[UtilityAISubsystem] the intervals are ignored, and instead the agents are
+// Scored round robin in batches of 64 for as long as the budget lasts (TimeSlicer.h).
+void utilityAISystem(World& world);
+// Every UtilityAgent needs this once when it's spawned, it's first scored delay ticks later
+void startUtilityTimer(World& world, EntityHandle agent, uint32_t delay);
+void drawUtilityAIStats(int x, int y);
+
+extern const System UtilityAIPhase;
@@ -16,6 +16,9 @@
 #include "Player.h"
 
 #include "ComposedAgents.h"
+#include "EcsScenarios.h"
+#include "AllocationTracker.h"
+#include "TargetPrediction.h"
 
 const int screenWidth = 1800;
 const int screenHeight = 1000;
@@ -26,12 +29,17 @@ Agent* mainAgent;
 Player* mainPlayer;
 
 ComposedAgents* ca;
+EcsScenarios* ecs;
 int assignmentPart = 0;
+const int assignmentPartCount = 3;
+bool showAllocations = false;
 
 void instantiateVariables() {
+    TRACK_ALLOCATIONS("instantiateVariables");
     mainAgent = new Agent(Vector2{ screenWidth / 2, screenWidth / 6 }, 25.0f, 5.0f, 0, 0.1f, true);
     mainPlayer = new Player(Vector2{screenWidth / 2, screenWidth / 2}, 25.0f, 8.0f);
     ca = new ComposedAgents();
+    ecs = new EcsScenarios();
 }
 
 // Note agent and player should ALSO deallocate in their deconstructors
@@ -39,6 +47,7 @@ void deallocate() {
     delete mainAgent;
     delete mainPlayer;
     delete ca;
+    delete ecs;
 }
 
 void update() {
@@ -49,20 +58,32 @@ void update() {
     else if (assignmentPart == 1) {
         ca->browseStates();
     }
+    else if (assignmentPart == 2) {
+        ecs->browseStates();
+    }
 }
 
 // Note: Move this somewhere else at some point
 void browseStates() {
-    string temp = "Assignment part: " + to_string(assignmentPart + 1) + "/2";
-    const char* stringState = temp.c_str();
-    DrawText(stringState, screenWidth - 250, screenHeight - 50, 20, RED);
+    // TextFormat writes into raylib's static buffer, building a std::string here allocated every frame
+    DrawText(TextFormat("Assignment part: %d/%d", assignmentPart + 1, assignmentPartCount), screenWidth - 250, screenHeight - 50, 20, RED);
 
     // Lock state between 0-2 (1-3 for UI)
     if (IsKeyPressed(KEY_LEFT) && assignmentPart != 0) {
         assignmentPart--;
+        AllocationTracker::markTransition();
     }
-    else if (IsKeyPressed(KEY_RIGHT) && assignmentPart != 1) {
+    else if (IsKeyPressed(KEY_RIGHT) && assignmentPart != assignmentPartCount - 1) {
         assignmentPart++;
+        AllocationTracker::markTransition();
+    }
+
+    // F1 shows per frame heap allocations (see AllocationTracker.h)
+    if (IsKeyPressed(KEY_F1)) {
+        showAllocations = !showAllocations;
+    }
+    if (showAllocations) {
+        AllocationTracker::drawOverlay(10, 40);
     }
 
     if (assignmentPart == 0) {
@@ -72,6 +93,9 @@ void browseStates() {
         ca->displayDebug();
         ca->browseStates();
     }
+    else if (assignmentPart == 2) {
+        ecs->displayDebug();
+    }
 }
 
 int main(void)
@@ -82,11 +106,14 @@ int main(void)
 
     while (!WindowShouldClose())
     {
+        AllocationTracker::beginFrame();
+        targetPredictions().nextFrame();
         BeginDrawing();
         ClearBackground(BLACK);
         DrawText(TextFormat("FPS: %d", GetFPS()), 10, 10, 20, RED);
         browseStates();
         update();
+        AllocationTracker::endFrame();
         EndDrawing();
     }
 